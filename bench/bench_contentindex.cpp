@@ -0,0 +1,193 @@
+//
+// Copyright (c) Milivoj (Mike) DAVIDOV
+//
+// THIS SOFTWARE IS PROVIDED "AS IS" WITHOUT WARRANTY OF ANY KIND,
+// EITHER EXPRESSED OR IMPLIED, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+// WARRANTIES OF MERCHANTABILITY AND/OR FITNESS FOR A PARTICULAR PURPOSE.
+//
+// The trigram content index: how fast it is built (on several threads,
+// as the content readers store() the files they read), saved and loaded,
+// and how much faster a word search is with it than reading every file.
+// The index is built in a temporary folder, not in the app's settings.
+//
+
+#include "benchutil.hpp"
+#include "contentindex.hpp"
+#include "contentmatcher.hpp"
+#include "contentsniffer.hpp"
+#include <algorithm>
+#include <atomic>
+#include <cstdio>
+#include <thread>
+#include <vector>
+#include <QCommandLineParser>
+#include <QCoreApplication>
+#include <QFile>
+#include <QFileInfo>
+#include <QTemporaryDir>
+
+using namespace mmd;
+
+namespace
+{
+    constexpr qint64 WINDOW_SIZE = 1024 * 1024;  // as ContentReader
+
+    /// @brief Reads @p path as a content reader does: a binary file is not
+    /// searched. Collects its trigrams into @p trigrams, if not null.
+    /// Returns whether it contains the words of @p matcher, if not null.
+    bool readFile(const QString& path, const ContentMatcher* matcher, TrigramSet* trigrams)
+    {
+        thread_local std::vector<char> buffer(WINDOW_SIZE);
+        QFile file(path);
+        if (!file.open(QIODevice::ReadOnly))
+            return false;
+        auto progress = matcher ? matcher->start() : ContentMatcher::Progress{};
+        for (bool first = true;; first = false) {
+            const auto len = file.read(buffer.data(), WINDOW_SIZE);
+            if (len <= 0)
+                break;
+            if (first && looksBinary(buffer.data(), std::min(std::size_t(len), SNIFF_SIZE))) {
+                if (trigrams)
+                    trigrams->setBinary();
+                return false;
+            }
+            if (trigrams)
+                trigrams->add(buffer.data(), std::size_t(len));
+            if (matcher && matcher->feed(progress, buffer.data(), std::size_t(len)) && !trigrams)
+                return matcher->matches(progress);
+        }
+        if (trigrams)
+            trigrams->setComplete();
+        if (!matcher)
+            return false;
+        matcher->finish(progress);
+        return matcher->matches(progress);
+    }
+
+    qint64 totalSize(const QStringList& files)
+    {
+        qint64 size = 0;
+        for (const auto& path : files)
+            size += QFileInfo(path).size();
+        return size;
+    }
+}
+
+int main(int argc, char* argv[])
+{
+    QCoreApplication app(argc, argv);
+    QCommandLineParser parser;
+    parser.setApplicationDescription(QStringLiteral(
+        "Builds the content index of a folder tree, then searches it for each word "
+        "(ignoring case), with the index and by reading every file."));
+    parser.addHelpOption();
+    const QCommandLineOption threadsOption(QStringLiteral("threads"),
+                                           QStringLiteral("Files read at once (default: the cores)."),
+                                           QStringLiteral("n"), QString::number(std::thread::hardware_concurrency()));
+    const QCommandLineOption coldOption(QStringLiteral("cold"),
+                                        QStringLiteral("Drop the page cache before each phase (run as root)."));
+    parser.addOption(threadsOption);
+    parser.addOption(coldOption);
+    parser.addPositionalArgument(QStringLiteral("folder"), QStringLiteral("Folder tree to index."));
+    parser.addPositionalArgument(QStringLiteral("words"), QStringLiteral("Words to search for."),
+                                 QStringLiteral("words..."));
+    parser.process(app);
+    auto args = parser.positionalArguments();
+    if (args.size() < 2)
+        parser.showHelp(1);
+    const auto files = bench::filesUnder(args.takeFirst());
+    const auto words = args;
+    const auto nbrThreads = std::max(parser.value(threadsOption).toUInt(), 1u);
+    const bool cold = parser.isSet(coldOption);
+    const auto startPhase = [cold] {
+        if (cold && !bench::dropCaches())
+            std::printf("cannot drop the page cache (run as root): the cache is warm\n");
+        return bench::Clock::now();
+    };
+    QTemporaryDir dir;
+    if (!dir.isValid()) {
+        std::printf("cannot create a temporary folder\n");
+        return 1;
+    }
+    const auto indexPath = dir.path() + QStringLiteral("/contentindex.bin");
+
+    // Build
+    const double mb = double(totalSize(files)) / 1e6;
+    auto start = startPhase();
+    {
+        ContentIndex index(indexPath);
+        index.load();
+        index.prepare({}, false, 0, false);
+        bench::parallelFor(std::size_t(files.size()), nbrThreads, [&](std::size_t i) {
+            const auto& path = files[qsizetype(i)];
+            const auto key = FileKey::of(path);
+            TrigramSet trigrams;
+            readFile(path, nullptr, &trigrams);
+            index.store(path, key, trigrams);
+        });
+        const auto buildTime = bench::secondsSince(start);
+        std::printf("%lld files, %.1f MB; %u threads\n", static_cast<long long>(files.size()), mb, nbrThreads);
+        std::printf("build: %8.2f s  %8.1f MB/s  (%.1f MB/s per core, %llu files indexed)\n", buildTime,
+                    mb / buildTime, index.buildMbPerSecond(),
+                    static_cast<unsigned long long>(index.indexedFiles()));
+        start = bench::Clock::now();
+        index.save();
+        std::printf("save:  %8.2f s  %8.1f MB on disk\n", bench::secondsSince(start),
+                    double(totalSize(bench::filesUnder(dir.path()))) / 1e6);
+    }
+    ContentIndex index(indexPath);
+    start = bench::Clock::now();
+    index.load();
+    std::printf("load:  %8.3f s\n", bench::secondsSince(start));
+
+    // Searches, as FolderScanner::compileMatchers() makes the query of a word
+    int exitCode = 0;
+    for (const auto& word : words) {
+        const ContentMatcher matcher(QStringList{ word }, false);
+        if (matcher.needsDecoding()) {
+            std::printf("%s: skipped, the index does not serve caseless non-ASCII words\n",
+                        word.toUtf8().constData());
+            continue;
+        }
+        const auto utf8 = word.toUtf8();
+        ContentIndex::Query query;
+        query.groups.push_back(ContentIndex::trigramsOf(utf8.constData(), std::size_t(utf8.size())));
+
+        std::atomic<std::size_t> nbrFound{ 0 };
+        start = startPhase();
+        bench::parallelFor(std::size_t(files.size()), nbrThreads, [&](std::size_t i) {
+            nbrFound += readFile(files[qsizetype(i)], &matcher, nullptr);
+        });
+        const auto readAllTime = bench::secondsSince(start);
+        const std::size_t nbrFoundAll = nbrFound;
+
+        nbrFound = 0;
+        std::atomic<std::size_t> nbrRead{ 0 };
+        start = startPhase();
+        index.prepare(query, false, 0, false);
+        bench::parallelFor(std::size_t(files.size()), nbrThreads, [&](std::size_t i) {
+            const auto& path = files[qsizetype(i)];
+            switch (index.check(path, FileKey::of(path))) {
+            case ContentIndex::Answer::NoMatch:
+            case ContentIndex::Answer::Binary:
+                return;
+            case ContentIndex::Answer::Candidate:
+            case ContentIndex::Answer::Unknown:
+                break;
+            }
+            nbrRead++;
+            nbrFound += readFile(path, &matcher, nullptr);
+        });
+        const auto indexedTime = bench::secondsSince(start);
+
+        std::printf("%s: %zu files found\n", utf8.constData(), nbrFoundAll);
+        std::printf("  every file read: %8.3f s\n", readAllTime);
+        std::printf("  with the index:  %8.3f s  (%.1fx); query %.2f ms, %zu files read\n", indexedTime,
+                    readAllTime / indexedTime, index.queryMilliseconds(), nbrRead.load());
+        if (nbrFound != nbrFoundAll) {
+            std::printf("  MISMATCH: %zu files found with the index\n", nbrFound.load());
+            exitCode = 1;
+        }
+    }
+    return exitCode;
+}
@@ -0,0 +1,166 @@
+//
+// Copyright (c) Milivoj (Mike) DAVIDOV
+//
+// THIS SOFTWARE IS PROVIDED "AS IS" WITHOUT WARRANTY OF ANY KIND,
+// EITHER EXPRESSED OR IMPLIED, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+// WARRANTIES OF MERCHANTABILITY AND/OR FITNESS FOR A PARTICULAR PURPOSE.
+//
+// Decompression throughput of gzip, zstd and xz files, as the content
+// readers decompress them: window by window through a Decompressor, capped
+// per file, on several threads at once. The decompressed MB/s per core is
+// the same figure as the status line's (DecompressionStats::mbPerSecond()).
+//
+
+#include "benchutil.hpp"
+#include "decompressor.hpp"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <thread>
+#include <vector>
+#include <QCommandLineParser>
+#include <QCoreApplication>
+#include <QFile>
+#include <QFileInfo>
+
+using namespace mmd;
+
+namespace
+{
+    constexpr std::size_t WINDOW_SIZE = 1024 * 1024;  // as ContentReader
+
+    struct FileCounts
+    {
+        std::atomic<std::uint64_t> nbrCompressedBytes{ 0 };
+        std::atomic<std::uint64_t> nbrUnsupported{ 0 };  // not compressed, or built without the library
+        std::atomic<std::uint64_t> nbrCorrupt{ 0 };
+    };
+
+    void decompressFile(const QString& path, std::uint64_t maxSize, std::uint64_t memLimit,
+                        DecompressionStats& stats, FileCounts& counts)
+    {
+        QFile file(path);
+        if (!file.open(QIODevice::ReadOnly))
+            return;
+        std::vector<char> inBuffer(WINDOW_SIZE);
+        std::vector<char> outBuffer(WINDOW_SIZE);
+        auto inLen = std::size_t(std::max<qint64>(file.read(inBuffer.data(), qint64(inBuffer.size())), 0));
+        const auto format = Decompressor::formatOf(inBuffer.data(), inLen);
+        if (format == Decompressor::Format::None || !Decompressor::isSupported(format)) {
+            counts.nbrUnsupported++;
+            return;
+        }
+        Decompressor decompressor(format, memLimit);
+        std::uint64_t nbrDecompressed = 0;
+        while (inLen > 0 && nbrDecompressed < maxSize) {
+            counts.nbrCompressedBytes += inLen;
+            const char* in = inBuffer.data();
+            bool ok = true;
+            const auto start = bench::Clock::now();
+            while (inLen > 0 && nbrDecompressed < maxSize) {
+                char* out = outBuffer.data();
+                auto outLeft = std::size_t(std::min<std::uint64_t>(WINDOW_SIZE, maxSize - nbrDecompressed));
+                const auto outSize = outLeft;
+                const auto inBefore = inLen;
+                ok = decompressor.decompress(in, inLen, out, outLeft);
+                nbrDecompressed += outSize - outLeft;
+                if (!ok || (inLen == inBefore && outLeft == outSize))
+                    break;
+            }
+            stats.nanoseconds += std::uint64_t(std::chrono::duration_cast<std::chrono::nanoseconds>(
+                bench::Clock::now() - start).count());
+            if (!ok && decompressor.overMemLimit()) {
+                // Not searched by the app either
+                stats.nbrOverLimit++;
+                return;
+            }
+            if (!ok) {
+                // Searched up to the corrupt data
+                counts.nbrCorrupt++;
+                break;
+            }
+            inLen = std::size_t(std::max<qint64>(file.read(inBuffer.data(), qint64(inBuffer.size())), 0));
+            if (inLen == 0) {
+                // The output the decoder still holds, as ContentReader drains it
+                const auto flushStart = bench::Clock::now();
+                while (nbrDecompressed < maxSize) {
+                    char* out = outBuffer.data();
+                    auto outLeft = std::size_t(std::min<std::uint64_t>(WINDOW_SIZE, maxSize - nbrDecompressed));
+                    const auto outSize = outLeft;
+                    ok = decompressor.flush(out, outLeft);
+                    nbrDecompressed += outSize - outLeft;
+                    if (!ok || outLeft > 0)
+                        break;
+                }
+                stats.nanoseconds += std::uint64_t(std::chrono::duration_cast<std::chrono::nanoseconds>(
+                    bench::Clock::now() - flushStart).count());
+                if (!ok)
+                    counts.nbrCorrupt++;
+            }
+        }
+        stats.nbrFiles++;
+        stats.nbrBytes += nbrDecompressed;
+    }
+}
+
+int main(int argc, char* argv[])
+{
+    QCoreApplication app(argc, argv);
+    QCommandLineParser parser;
+    parser.setApplicationDescription(QStringLiteral(
+        "Decompressed MB/s per core of gzip, zstd and xz files (the others are skipped)."));
+    parser.addHelpOption();
+    const QCommandLineOption threadsOption(QStringLiteral("threads"),
+                                           QStringLiteral("Files decompressed at once (default: the cores)."),
+                                           QStringLiteral("n"), QString::number(std::thread::hardware_concurrency()));
+    const QCommandLineOption maxSizeOption(QStringLiteral("max-size"),
+                                           QStringLiteral("Decompressed MB searched per file (default 1024)."),
+                                           QStringLiteral("MB"), QStringLiteral("1024"));
+    const QCommandLineOption memLimitOption(QStringLiteral("mem-limit"),
+                                            QStringLiteral("Decoder memory limit in MB (default 128)."),
+                                            QStringLiteral("MB"), QStringLiteral("128"));
+    parser.addOption(threadsOption);
+    parser.addOption(maxSizeOption);
+    parser.addOption(memLimitOption);
+    parser.addPositionalArgument(QStringLiteral("paths"), QStringLiteral("Compressed files, or folders of them."),
+                                 QStringLiteral("paths..."));
+    parser.process(app);
+    if (parser.positionalArguments().isEmpty())
+        parser.showHelp(1);
+
+    QStringList files;
+    for (const auto& path : parser.positionalArguments()) {
+        if (QFileInfo(path).isDir())
+            files += bench::filesUnder(path);
+        else
+            files << path;
+    }
+    const auto nbrThreads = std::max(parser.value(threadsOption).toUInt(), 1u);
+    const auto maxSize = parser.value(maxSizeOption).toULongLong() * 1024 * 1024;
+    const auto memLimit = parser.value(memLimitOption).toULongLong() * 1024 * 1024;
+
+    DecompressionStats stats;
+    FileCounts counts;
+    const auto start = bench::Clock::now();
+    bench::parallelFor(std::size_t(files.size()), nbrThreads, [&](std::size_t i) {
+        decompressFile(files[qsizetype(i)], maxSize, memLimit, stats, counts);
+    });
+    const auto seconds = bench::secondsSince(start);
+
+    const double mb = double(stats.nbrBytes) / 1e6;
+    std::printf("%llu files decompressed on %u threads: %.1f MB from %.1f MB\n",
+                static_cast<unsigned long long>(stats.nbrFiles.load()), nbrThreads, mb,
+                double(counts.nbrCompressedBytes) / 1e6);
+    std::printf("per core: %8.1f MB/s (%.2f s decompressing)\n", stats.mbPerSecond(),
+                double(stats.nanoseconds) / 1e9);
+    std::printf("overall:  %8.1f MB/s (%.2f s)\n", seconds > 0 ? mb / seconds : 0.0, seconds);
+    if (counts.nbrUnsupported > 0)
+        std::printf("%llu files skipped (not compressed, or no library for their format)\n",
+                    static_cast<unsigned long long>(counts.nbrUnsupported.load()));
+    if (stats.nbrOverLimit > 0)
+        std::printf("%llu files over the memory limit\n", static_cast<unsigned long long>(stats.nbrOverLimit.load()));
+    if (counts.nbrCorrupt > 0)
+        std::printf("%llu corrupt files\n", static_cast<unsigned long long>(counts.nbrCorrupt.load()));
+    return 0;
+}
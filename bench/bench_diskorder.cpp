@@ -0,0 +1,117 @@
+//
+// Copyright (c) Milivoj (Mike) DAVIDOV
+//
+// THIS SOFTWARE IS PROVIDED "AS IS" WITHOUT WARRANTY OF ANY KIND,
+// EITHER EXPRESSED OR IMPLIED, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+// WARRANTIES OF MERCHANTABILITY AND/OR FITNESS FOR A PARTICULAR PURPOSE.
+//
+// Reading the files of a folder tree in listing order, and in disk order
+// (DiskOrder::sort() of each batch, as FolderScanner::scheduleReads() does).
+// Each run starts on a cold cache, so the gain is that of the disk: mostly
+// seen on rotational disks, where reading in disk order saves seeks.
+//
+
+#include "benchutil.hpp"
+#include "diskorder.hpp"
+#include <algorithm>
+#include <cstdio>
+#include <iterator>
+#include <vector>
+#include <QCommandLineParser>
+#include <QCoreApplication>
+#include <QFile>
+
+using namespace mmd;
+
+namespace
+{
+    constexpr qint64 WINDOW_SIZE = 1024 * 1024;  // as ContentReader
+
+    /// Reads all of @p files, one after another; returns the bytes read
+    qint64 readAll(const std::vector<FsEntry>& files)
+    {
+        std::vector<char> buffer(WINDOW_SIZE);
+        qint64 nbrBytes = 0;
+        for (const auto& entry : files) {
+            QFile file(entry.path);
+            if (!file.open(QIODevice::ReadOnly))
+                continue;
+            for (qint64 len; (len = file.read(buffer.data(), WINDOW_SIZE)) > 0;)
+                nbrBytes += len;
+        }
+        return nbrBytes;
+    }
+}
+
+int main(int argc, char* argv[])
+{
+    QCoreApplication app(argc, argv);
+    QCommandLineParser parser;
+    parser.setApplicationDescription(QStringLiteral(
+        "Reads the files of a folder tree in listing order and in disk order, on a cold cache (run as root)."));
+    parser.addHelpOption();
+    const QCommandLineOption runsOption(QStringLiteral("runs"), QStringLiteral("Runs of each order (default 3)."),
+                                        QStringLiteral("n"), QStringLiteral("3"));
+    // As FolderScanner::READ_BATCH_SIZE
+    const QCommandLineOption batchOption(QStringLiteral("batch"),
+                                         QStringLiteral("Files sorted at a time, 0 for all (default 1024)."),
+                                         QStringLiteral("n"), QStringLiteral("1024"));
+    parser.addOption(runsOption);
+    parser.addOption(batchOption);
+    parser.addPositionalArgument(QStringLiteral("folder"), QStringLiteral("Folder tree to read."));
+    parser.process(app);
+    if (parser.positionalArguments().size() != 1)
+        parser.showHelp(1);
+
+    const auto folder = parser.positionalArguments().first();
+    std::vector<FsEntry> listed;
+    for (const auto& path : bench::filesUnder(folder)) {
+        FsEntry entry;
+        entry.path = path;
+        entry.type = FsEntry::Type::File;
+        listed.push_back(std::move(entry));
+    }
+    const bool cold = bench::dropCaches();
+    std::printf("%zu files; %s disk; %s cache\n", listed.size(),
+                DiskOrder::isRotational(folder) ? "rotational" : "non-rotational (or unknown)",
+                cold ? "cold" : "WARM (cannot drop the caches: run as root)");
+
+    // The disk order, batch by batch, from a cold cache too
+    auto batchSize = std::size_t(parser.value(batchOption).toULongLong());
+    if (batchSize == 0)
+        batchSize = std::max<std::size_t>(listed.size(), 1);
+    bench::dropCaches();
+    auto start = bench::Clock::now();
+    std::vector<FsEntry> sorted;
+    for (std::size_t first = 0; first < listed.size(); first += batchSize) {
+        std::vector<FsEntry> batch(listed.begin() + std::ptrdiff_t(first),
+                                   listed.begin() + std::ptrdiff_t(std::min(first + batchSize, listed.size())));
+        DiskOrder::sort(batch);
+        std::move(batch.begin(), batch.end(), std::back_inserter(sorted));
+    }
+    std::printf("sorted in batches of %zu in %.3f s\n", batchSize, bench::secondsSince(start));
+
+    const int nbrRuns = std::max(parser.value(runsOption).toInt(), 1);
+    std::vector<double> listedTimes;
+    std::vector<double> sortedTimes;
+    qint64 nbrBytes = 0;
+    for (int run = 0; run < nbrRuns; ++run) {
+        // Alternate which order is read first
+        for (int i = 0; i < 2; ++i) {
+            const bool inDiskOrder = (run + i) % 2 == 1;
+            bench::dropCaches();
+            start = bench::Clock::now();
+            nbrBytes = readAll(inDiskOrder ? sorted : listed);
+            (inDiskOrder ? sortedTimes : listedTimes).push_back(bench::secondsSince(start));
+        }
+    }
+
+    const double mb = double(nbrBytes) / 1e6;
+    const auto listedTime = bench::median(listedTimes);
+    const auto sortedTime = bench::median(sortedTimes);
+    std::printf("%.1f MB read\n", mb);
+    std::printf("listing order: %8.3f s  %8.1f MB/s\n", listedTime, mb / listedTime);
+    std::printf("disk order:    %8.3f s  %8.1f MB/s  (%.2fx)\n", sortedTime, mb / sortedTime,
+                listedTime / sortedTime);
+    return 0;
+}
@@ -0,0 +1,136 @@
+//
+// Copyright (c) Milivoj (Mike) DAVIDOV
+//
+// THIS SOFTWARE IS PROVIDED "AS IS" WITHOUT WARRANTY OF ANY KIND,
+// EITHER EXPRESSED OR IMPLIED, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+// WARRANTIES OF MERCHANTABILITY AND/OR FITNESS FOR A PARTICULAR PURPOSE.
+//
+// Matching paths against the exclusion patterns: the AhoCorasick automaton
+// that FolderScanner::compileMatchers() builds, against a loop of
+// QString::contains() over the patterns (containsAnyWord() below).
+// The paths and patterns are random words, generated from a seed.
+//
+
+#include "ahocorasick.hpp"
+#include "benchutil.hpp"
+#include <cstdio>
+#include <random>
+#include <string>
+#include <vector>
+#include <QChar>
+#include <QCommandLineParser>
+#include <QCoreApplication>
+
+using namespace mmd;
+
+namespace
+{
+    QString randomWord(std::mt19937& random)
+    {
+        static const char LETTERS[] = "abcdefghijklmnopqrstuvwxyzABCDEFGHIJKLMNOPQRSTUVWXYZ0123456789_-";
+        std::uniform_int_distribution<int> length(3, 10);
+        std::uniform_int_distribution<std::size_t> letter(0, sizeof(LETTERS) - 2);
+        QString word;
+        for (int i = length(random); i > 0; --i)
+            word += QLatin1Char(LETTERS[letter(random)]);
+        return word;
+    }
+
+    bool containsAnyWord(const QString& str, const QStringList& words, Qt::CaseSensitivity cs)
+    {
+        for (const auto& word : words) {
+            if (str.contains(word, cs))
+                return true;
+        }
+        return false;
+    }
+}
+
+int main(int argc, char* argv[])
+{
+    QCoreApplication app(argc, argv);
+    QCommandLineParser parser;
+    parser.setApplicationDescription(QStringLiteral(
+        "Exclusion patterns matched by one automaton against a QString::contains() loop."));
+    parser.addHelpOption();
+    const QCommandLineOption pathsOption(QStringLiteral("paths"), QStringLiteral("Paths (default 200000)."),
+                                         QStringLiteral("n"), QStringLiteral("200000"));
+    const QCommandLineOption patternsOption(QStringLiteral("patterns"), QStringLiteral("Patterns (default 60)."),
+                                            QStringLiteral("n"), QStringLiteral("60"));
+    const QCommandLineOption seedOption(QStringLiteral("seed"), QStringLiteral("Random seed (default 1)."),
+                                        QStringLiteral("n"), QStringLiteral("1"));
+    parser.addOption(pathsOption);
+    parser.addOption(patternsOption);
+    parser.addOption(seedOption);
+    parser.process(app);
+    if (!parser.positionalArguments().isEmpty())
+        parser.showHelp(1);
+
+    // Paths of 6 to 10 words from a vocabulary, about 60 characters long
+    std::mt19937 random(parser.value(seedOption).toUInt());
+    QStringList vocabulary;
+    for (int i = 0; i < 2000; ++i)
+        vocabulary << randomWord(random);
+    std::uniform_int_distribution<qsizetype> pick(0, vocabulary.size() - 1);
+    std::uniform_int_distribution<int> depth(6, 10);
+    QStringList paths;
+    for (int i = parser.value(pathsOption).toInt(); i > 0; --i) {
+        QString path;
+        for (int d = depth(random); d > 0; --d) {
+            path += QLatin1Char('/');
+            path += vocabulary[pick(random)];
+        }
+        paths << path;
+    }
+    // Patterns from the same vocabulary, some in another case
+    QStringList patterns;
+    for (int i = parser.value(patternsOption).toInt(); i > 0; --i) {
+        const auto& word = vocabulary[pick(random)];
+        patterns << (i % 3 == 0 ? word.toLower() : word);
+    }
+    std::vector<std::u16string> u16Patterns;
+    for (const auto& pattern : patterns)
+        u16Patterns.emplace_back(reinterpret_cast<const char16_t*>(pattern.utf16()), std::size_t(pattern.size()));
+    qsizetype pathChars = 0;
+    for (const auto& path : paths)
+        pathChars += path.size();
+    std::printf("%lld paths of %lld characters on average, %lld patterns\n", static_cast<long long>(paths.size()),
+                static_cast<long long>(paths.isEmpty() ? 0 : pathChars / paths.size()),
+                static_cast<long long>(patterns.size()));
+
+    int exitCode = 0;
+    for (const bool matchCase : { true, false }) {
+        const auto cs = matchCase ? Qt::CaseSensitive : Qt::CaseInsensitive;
+        auto start = bench::Clock::now();
+        std::size_t loopMatches = 0;
+        for (const auto& path : paths)
+            loopMatches += containsAnyWord(path, patterns, cs);
+        const auto loopTime = bench::secondsSince(start);
+
+        // As FolderScanner::compileMatchers()
+        start = bench::Clock::now();
+        AhoCorasick<char16_t>::Fold fold = nullptr;
+        if (!matchCase) {
+            fold = [](char16_t c) { return char16_t(QChar::toCaseFolded(char32_t(c))); };
+        }
+        const AhoCorasick<char16_t> matcher(u16Patterns, fold);
+        const auto compileTime = bench::secondsSince(start);
+        start = bench::Clock::now();
+        std::size_t automatonMatches = 0;
+        for (const auto& path : paths) {
+            automatonMatches +=
+                matcher.containsAny(reinterpret_cast<const char16_t*>(path.utf16()), std::size_t(path.size()));
+        }
+        const auto automatonTime = bench::secondsSince(start);
+
+        std::printf("%s: %zu paths excluded\n", matchCase ? "match case" : "ignore case", loopMatches);
+        std::printf("  contains() loop: %8.1f ms\n", loopTime * 1000.0);
+        std::printf("  automaton:       %8.1f ms  (%.1fx), compiled in %.2f ms\n", automatonTime * 1000.0,
+                    loopTime / automatonTime, compileTime * 1000.0);
+        if (automatonMatches != loopMatches) {
+            std::printf("  MISMATCH: the automaton excluded %zu paths\n", automatonMatches);
+            exitCode = 1;
+        }
+    }
+    return exitCode;
+}
@@ -0,0 +1,137 @@
+//
+// Copyright (c) Milivoj (Mike) DAVIDOV
+//
+// THIS SOFTWARE IS PROVIDED "AS IS" WITHOUT WARRANTY OF ANY KIND,
+// EITHER EXPRESSED OR IMPLIED, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+// WARRANTIES OF MERCHANTABILITY AND/OR FITNESS FOR A PARTICULAR PURPOSE.
+//
+// Batched statx() through io_uring (UringStatx::statBatch) against one
+// synchronous statx() per entry (UringStatx::statSync), as the Linux
+// directory lister calls them: every entry of a directory in one batch,
+// for its size and modification time. Each run starts on a cold cache.
+//
+
+#include "benchutil.hpp"
+#include "uringstatx_linux.hpp"
+#include <cstdio>
+#include <string>
+#include <vector>
+#include <QCommandLineParser>
+#include <QCoreApplication>
+#include <dirent.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+using namespace mmd;
+
+namespace
+{
+    struct Directory
+    {
+        std::string path;
+        std::vector<std::string> names;
+    };
+
+    /// The directories under @p path and their entry names (listed once, before the runs)
+    void listTree(const std::string& path, std::vector<Directory>& dirs)
+    {
+        auto* dir = ::opendir(path.c_str());
+        if (!dir)
+            return;
+        Directory listed{ path, {} };
+        std::vector<std::string> subDirs;
+        while (const auto* entry = ::readdir(dir)) {
+            const std::string name = entry->d_name;
+            if (name == "." || name == "..")
+                continue;
+            listed.names.push_back(name);
+            if (entry->d_type == DT_DIR)
+                subDirs.push_back(path + '/' + name);
+        }
+        ::closedir(dir);
+        dirs.push_back(std::move(listed));
+        for (const auto& subDir : subDirs)
+            listTree(subDir, dirs);
+    }
+
+    /// Stats all the entries of @p dirs; returns the number of failures
+    std::size_t statTree(const std::vector<Directory>& dirs, bool batched, unsigned mask)
+    {
+        auto& uring = UringStatx::forThread();
+        std::vector<const char*> names;
+        std::vector<struct statx> stats;
+        std::vector<int> results;
+        std::size_t nbrFailed = 0;
+        for (const auto& dir : dirs) {
+            const int dirFd = ::open(dir.path.c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+            if (dirFd < 0) {
+                nbrFailed += dir.names.size();
+                continue;
+            }
+            names.clear();
+            for (const auto& name : dir.names)
+                names.push_back(name.c_str());
+            if (batched)
+                uring.statBatch(dirFd, names, mask, stats, results);
+            else
+                UringStatx::statSync(dirFd, names, mask, stats, results);
+            for (const auto result : results)
+                nbrFailed += result != 0;
+            ::close(dirFd);
+        }
+        return nbrFailed;
+    }
+}
+
+int main(int argc, char* argv[])
+{
+    QCoreApplication app(argc, argv);
+    QCommandLineParser parser;
+    parser.setApplicationDescription(QStringLiteral(
+        "Batched statx() through io_uring against one statx() per entry, on a cold cache (run as root)."));
+    parser.addHelpOption();
+    const QCommandLineOption runsOption(QStringLiteral("runs"), QStringLiteral("Runs of each method (default 3)."),
+                                        QStringLiteral("n"), QStringLiteral("3"));
+    parser.addOption(runsOption);
+    parser.addPositionalArgument(QStringLiteral("folder"), QStringLiteral("Folder tree to stat."));
+    parser.process(app);
+    if (parser.positionalArguments().size() != 1)
+        parser.showHelp(1);
+
+    std::vector<Directory> dirs;
+    listTree(QDir(parser.positionalArguments().first()).absolutePath().toStdString(), dirs);
+    std::size_t nbrEntries = 0;
+    for (const auto& dir : dirs)
+        nbrEntries += dir.names.size();
+    const bool uringAvailable = UringStatx::forThread().isAvailable();
+    const bool cold = bench::dropCaches();
+    std::printf("%zu directories, %zu entries; io_uring %s; %s cache\n", dirs.size(), nbrEntries,
+                uringAvailable ? "available" : "NOT available (both methods are synchronous)",
+                cold ? "cold" : "WARM (cannot drop the caches: run as root)");
+
+    const unsigned mask = STATX_SIZE | STATX_MTIME;
+    const int nbrRuns = std::max(parser.value(runsOption).toInt(), 1);
+    std::vector<double> syncTimes;
+    std::vector<double> batchedTimes;
+    std::size_t nbrFailed = 0;
+    for (int run = 0; run < nbrRuns; ++run) {
+        // Alternate which method runs first
+        for (int i = 0; i < 2; ++i) {
+            const bool batched = (run + i) % 2 == 1;
+            bench::dropCaches();
+            const auto start = bench::Clock::now();
+            nbrFailed += statTree(dirs, batched, mask);
+            (batched ? batchedTimes : syncTimes).push_back(bench::secondsSince(start));
+        }
+    }
+
+    const auto syncTime = bench::median(syncTimes);
+    const auto batchedTime = bench::median(batchedTimes);
+    std::printf("statx per entry:  %8.3f s  %10.0f entries/s\n", syncTime, double(nbrEntries) / syncTime);
+    std::printf("io_uring batches: %8.3f s  %10.0f entries/s  (%.2fx)\n", batchedTime,
+                double(nbrEntries) / batchedTime, syncTime / batchedTime);
+    if (nbrFailed > 0)
+        std::printf("%zu statx calls failed\n", nbrFailed);
+    return 0;
+}
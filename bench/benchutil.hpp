@@ -0,0 +1,85 @@
+#pragma once
+//
+// Copyright (c) Milivoj (Mike) DAVIDOV
+//
+// THIS SOFTWARE IS PROVIDED "AS IS" WITHOUT WARRANTY OF ANY KIND,
+// EITHER EXPRESSED OR IMPLIED, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+// WARRANTIES OF MERCHANTABILITY AND/OR FITNESS FOR A PARTICULAR PURPOSE.
+//
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <thread>
+#include <vector>
+#include <QDir>
+#include <QDirIterator>
+#include <QString>
+#include <QStringList>
+#if defined(Q_OS_LINUX)
+#include <cstdio>
+#include <unistd.h>
+#endif
+
+/// Helpers shared by the benchmarks
+namespace mmd::bench
+{
+    using Clock = std::chrono::steady_clock;
+
+    inline double secondsSince(Clock::time_point start)
+    {
+        return std::chrono::duration<double>(Clock::now() - start).count();
+    }
+
+    inline double median(std::vector<double> values)
+    {
+        if (values.empty())
+            return 0.0;
+        std::sort(values.begin(), values.end());
+        return values[values.size() / 2];
+    }
+
+    /// @brief Evicts the page, dentry and inode caches (Linux, as root), so
+    /// that the next run reads from the disk. Returns false if it cannot.
+    inline bool dropCaches()
+    {
+#if defined(Q_OS_LINUX)
+        ::sync();
+        auto* file = std::fopen("/proc/sys/vm/drop_caches", "w");
+        if (!file)
+            return false;
+        const bool written = std::fputs("3\n", file) >= 0;
+        return std::fclose(file) == 0 && written;
+#else
+        return false;
+#endif
+    }
+
+    /// The regular files under @p folder (symbolic links not followed), in listing order
+    inline QStringList filesUnder(const QString& folder)
+    {
+        QStringList files;
+        QDirIterator it(folder, QDir::Files | QDir::Hidden | QDir::System | QDir::NoSymLinks,
+                        QDirIterator::Subdirectories);
+        while (it.hasNext())
+            files << it.next();
+        return files;
+    }
+
+    /// Calls @p work(i) for each i in [0, @p count) on @p nbrThreads threads, each taking the next i
+    template <typename Work>
+    void parallelFor(std::size_t count, unsigned nbrThreads, Work work)
+    {
+        std::atomic<std::size_t> next{ 0 };
+        std::vector<std::thread> threads;
+        for (unsigned t = 0; t < std::max(nbrThreads, 1u); ++t) {
+            threads.emplace_back([&] {
+                for (auto i = next++; i < count; i = next++)
+                    work(i);
+            });
+        }
+        for (auto& thread : threads)
+            thread.join();
+    }
+}
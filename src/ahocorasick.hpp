@@ -0,0 +1,183 @@
+#pragma once
+//
+// Copyright (c) Milivoj (Mike) DAVIDOV
+//
+// THIS SOFTWARE IS PROVIDED "AS IS" WITHOUT WARRANTY OF ANY KIND,
+// EITHER EXPRESSED OR IMPLIED, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+// WARRANTIES OF MERCHANTABILITY AND/OR FITNESS FOR A PARTICULAR PURPOSE.
+//
+
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <queue>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+namespace mmd
+{
+/// @brief Aho-Corasick multi-pattern matcher, compiled into a full DFA
+/// (every state has a transition for every input), so a text is checked
+/// for all the patterns in one linear pass, one table lookup per character.
+/// The alphabet is compressed to the characters that occur in the patterns
+/// (all the others share one class), which keeps the table small even for
+/// 16-bit characters.
+/// Case-insensitive matching is done by the character classes too: each
+/// character is in the class of its case-folded form, so matching costs the same.
+/// Each state also has the set of patterns that end there (outputs()),
+/// for callers that need to know which patterns were found.
+/// @author Milivoj (Mike) DAVIDOV
+///
+template <typename CharT>
+class AhoCorasick
+{
+public:
+    using UChar = std::make_unsigned_t<CharT>;
+    using String = std::basic_string<CharT>;
+    /// Maps a character to its case-folded form
+    using Fold = CharT (*)(CharT);
+    using State = std::uint32_t;
+
+    AhoCorasick() = default;
+
+    /// @brief Compiles @p patterns; @p fold is nullptr to match case.
+    explicit AhoCorasick(const std::vector<String>& patterns, Fold fold = nullptr)
+    {
+        compile(patterns, fold);
+    }
+
+    bool empty() const { return nbrPatterns == 0; }
+
+    static constexpr State start() { return 0; }
+
+    State step(State state, CharT c) const {
+        return table[std::size_t(state) * nbrClasses + classOf[UChar(c)]];
+    }
+
+    /// True if a pattern ends at this state.
+    bool isMatch(State state) const { return accepting[state] != 0; }
+
+    std::size_t size() const { return nbrPatterns; }
+
+    /// Words of the bit set of pattern indices returned by outputs()
+    std::size_t outputWords() const { return nbrOutputWords; }
+
+    /// Bit set of the patterns that end at this state (bit i: patterns[i]).
+    const std::uint64_t* outputs(State state) const {
+        return &outputMasks[std::size_t(state) * nbrOutputWords];
+    }
+
+    /// Returns true if @p text contains at least one of the patterns.
+    bool containsAny(const CharT* text, std::size_t len) const
+    {
+        if (empty())
+            return false;
+        State state = start();
+        if (isMatch(state))
+            return true;  // an empty pattern
+        for (std::size_t i = 0; i < len; ++i) {
+            state = step(state, text[i]);
+            if (accepting[state])
+                return true;
+        }
+        return false;
+    }
+
+private:
+    void compile(const std::vector<String>& patterns, Fold fold)
+    {
+        nbrPatterns = patterns.size();
+        constexpr std::size_t CHARSET_SIZE = std::size_t(std::numeric_limits<UChar>::max()) + 1;
+        classOf.assign(CHARSET_SIZE, 0);
+        nbrClasses = 1;  // class 0: characters that are in no pattern
+
+        // Characters of the (folded) patterns
+        std::vector<String> folded = patterns;
+        for (auto& pattern : folded) {
+            for (auto& c : pattern) {
+                if (fold)
+                    c = fold(c);
+                auto& cls = classOf[UChar(c)];
+                if (cls == 0)
+                    cls = ClassId(nbrClasses++);
+            }
+        }
+        if (fold) {
+            // Every character that folds to a pattern character is in its class
+            for (std::size_t c = 0; c < CHARSET_SIZE; ++c) {
+                const auto f = UChar(fold(CharT(c)));
+                if (classOf[c] == 0 && classOf[f] != 0)
+                    classOf[c] = classOf[f];
+            }
+        }
+
+        // Trie
+        constexpr State NONE = std::numeric_limits<State>::max();
+        nbrOutputWords = (nbrPatterns + 63) / 64;
+        table.assign(nbrClasses, NONE);
+        accepting.assign(1, 0);
+        outputMasks.assign(nbrOutputWords, 0);
+        for (std::size_t i = 0; i < folded.size(); ++i) {
+            State state = start();
+            for (const auto c : folded[i]) {
+                const auto idx = std::size_t(state) * nbrClasses + classOf[UChar(c)];
+                if (table[idx] == NONE) {
+                    table[idx] = State(accepting.size());
+                    table.resize(table.size() + nbrClasses, NONE);
+                    accepting.push_back(0);
+                    outputMasks.resize(outputMasks.size() + nbrOutputWords, 0);
+                }
+                state = table[idx];
+            }
+            accepting[state] = 1;
+            outputMasks[std::size_t(state) * nbrOutputWords + i / 64] |= std::uint64_t(1) << (i % 64);
+        }
+
+        // Failure links, folded into the transitions (breadth first)
+        std::vector<State> fail(accepting.size(), start());
+        std::queue<State> queue;
+        for (std::size_t cls = 0; cls < nbrClasses; ++cls) {
+            auto& next = table[cls];
+            if (next == NONE) {
+                next = start();
+            }
+            else {
+                fail[next] = start();
+                queue.push(next);
+            }
+        }
+        while (!queue.empty()) {
+            const auto state = queue.front();
+            queue.pop();
+            accepting[state] |= accepting[fail[state]];
+            for (std::size_t w = 0; w < nbrOutputWords; ++w) {
+                outputMasks[std::size_t(state) * nbrOutputWords + w] |=
+                    outputMasks[std::size_t(fail[state]) * nbrOutputWords + w];
+            }
+            for (std::size_t cls = 0; cls < nbrClasses; ++cls) {
+                auto& next = table[std::size_t(state) * nbrClasses + cls];
+                const auto failNext = table[std::size_t(fail[state]) * nbrClasses + cls];
+                if (next == NONE) {
+                    next = failNext;
+                }
+                else {
+                    fail[next] = failNext;
+                    queue.push(next);
+                }
+            }
+        }
+    }
+
+    using ClassId = std::uint16_t;
+
+    std::size_t nbrPatterns{ 0 };
+    std::size_t nbrClasses{ 1 };
+    std::vector<ClassId> classOf;      // character -> class
+    std::vector<State> table;          // state * nbrClasses + class -> state
+    std::vector<std::uint8_t> accepting;
+    std::size_t nbrOutputWords{ 0 };
+    std::vector<std::uint64_t> outputMasks;  // state * nbrOutputWords + word
+};
+
+}
@@ -0,0 +1,373 @@
+//
+// Copyright (c) Milivoj (Mike) DAVIDOV
+//
+// THIS SOFTWARE IS PROVIDED "AS IS" WITHOUT WARRANTY OF ANY KIND,
+// EITHER EXPRESSED OR IMPLIED, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+// WARRANTIES OF MERCHANTABILITY AND/OR FITNESS FOR A PARTICULAR PURPOSE.
+//
+
+#include "archivereader.hpp"
+#include <algorithm>
+#include <cstring>
+#include <optional>
+#include <string_view>
+#include <QByteArray>
+#include <QDateTime>
+#include <QDir>
+#include <QFile>
+
+namespace mmd
+{
+namespace
+{
+const auto MEMBER_SEPARATOR = QStringLiteral("!/");
+
+// Bigger central directories are not listed (a million members or so)
+constexpr qint64 MAX_ZIP_DIRECTORY_SIZE = 256 * 1024 * 1024;
+constexpr qint64 TAR_BLOCK_SIZE = 512;
+
+quint64 readLE(const char* p, int nbrBytes)
+{
+    quint64 value = 0;
+    for (int i = nbrBytes - 1; i >= 0; --i)
+        value = (value << 8) | static_cast<unsigned char>(p[i]);
+    return value;
+}
+
+bool endsWithNoCase(const char* name, std::size_t len, std::string_view suffix)
+{
+    if (len < suffix.size())
+        return false;
+    const auto* end = name + len - suffix.size();
+    for (std::size_t i = 0; i < suffix.size(); ++i) {
+        auto c = end[i];
+        if (c >= 'A' && c <= 'Z')
+            c = char(c - 'A' + 'a');
+        if (c != suffix[i])
+            return false;
+    }
+    return true;
+}
+
+QString cleanName(QString name)
+{
+    while (name.startsWith(QStringLiteral("./")))
+        name.remove(0, 2);
+    while (name.startsWith(u'/'))
+        name.remove(0, 1);
+    while (name.endsWith(u'/'))
+        name.chop(1);
+    return name;
+}
+
+/// MS-DOS date and time (local), as in zip headers
+qint64 dosTimeToMsecs(quint64 time, quint64 date)
+{
+    const QDate day(int((date >> 9) & 0x7f) + 1980, int((date >> 5) & 0x0f), int(date & 0x1f));
+    const QTime clock(int((time >> 11) & 0x1f), int((time >> 5) & 0x3f), int(time & 0x1f) * 2);
+    const QDateTime dateTime(day, clock);
+    return dateTime.isValid() ? dateTime.toMSecsSinceEpoch() : -1;
+}
+
+/// A tar header number: octal text, or base-256 if the high bit of the first byte is set
+quint64 tarNumber(const char* field, std::size_t len)
+{
+    quint64 value = 0;
+    if (static_cast<unsigned char>(field[0]) & 0x80) {
+        value = static_cast<unsigned char>(field[0]) & 0x7f;
+        for (std::size_t i = 1; i < len; ++i)
+            value = (value << 8) | static_cast<unsigned char>(field[i]);
+        return value;
+    }
+    std::size_t i = 0;
+    while (i < len && (field[i] == ' ' || field[i] == '\0'))
+        ++i;
+    for (; i < len && field[i] >= '0' && field[i] <= '7'; ++i)
+        value = (value << 3) | quint64(field[i] - '0');
+    return value;
+}
+
+QString tarString(const char* field, std::size_t len)
+{
+    return QString::fromUtf8(field, qsizetype(strnlen(field, len)));
+}
+
+bool tarChecksumOk(const char* header)
+{
+    // The sum of the header bytes, with the checksum field as spaces
+    quint64 sum = 0;
+    for (int i = 0; i < TAR_BLOCK_SIZE; ++i)
+        sum += (i >= 148 && i < 156) ? quint64(' ') : static_cast<unsigned char>(header[i]);
+    return sum == tarNumber(header + 148, 8);
+}
+
+/// The "path" (and "size", "mtime") records of a pax extended header
+void parsePax(const QByteArray& data, QString& path, std::optional<quint64>& size, qint64& mtime)
+{
+    qsizetype pos = 0;
+    while (pos < data.size()) {
+        // "<length> <key>=<value>\n", length including itself
+        const auto space = data.indexOf(' ', pos);
+        if (space < 0)
+            return;
+        bool ok = false;
+        const auto len = data.mid(pos, space - pos).toLongLong(&ok);
+        if (!ok || len <= space - pos || pos + len > data.size())
+            return;
+        const auto record = data.mid(space + 1, len - (space - pos) - 2);  // no '\n'
+        const auto eq = record.indexOf('=');
+        if (eq > 0) {
+            const auto key = record.left(eq);
+            const auto value = record.mid(eq + 1);
+            if (key == "path")
+                path = QString::fromUtf8(value);
+            else if (key == "size")
+                size = value.toULongLong();
+            else if (key == "mtime")
+                mtime = qint64(value.toDouble() * 1000.0);
+        }
+        pos += len;
+    }
+}
+}
+
+ArchiveReader::Kind ArchiveReader::kindOf(const char* fileName, std::size_t len)
+{
+    if (endsWithNoCase(fileName, len, ".zip") || endsWithNoCase(fileName, len, ".jar"))
+        return Kind::Zip;
+    if (endsWithNoCase(fileName, len, ".tar"))
+        return Kind::Tar;
+    return Kind::None;
+}
+
+ArchiveReader::Kind ArchiveReader::kindOf(const QString& fileName)
+{
+    const auto utf8 = fileName.toUtf8();
+    return kindOf(utf8.constData(), std::size_t(utf8.size()));
+}
+
+QString ArchiveReader::memberPath(const QString& archivePath, const QString& name)
+{
+    return archivePath + MEMBER_SEPARATOR + name;
+}
+
+QString ArchiveReader::diskPath(const QString& path)
+{
+    const auto normalized = QDir::fromNativeSeparators(path);
+    const auto sep = normalized.indexOf(MEMBER_SEPARATOR);
+    return sep < 0 ? path : QDir::toNativeSeparators(normalized.left(sep));
+}
+
+bool ArchiveReader::isMemberPath(const QString& path)
+{
+    return QDir::fromNativeSeparators(path).contains(MEMBER_SEPARATOR);
+}
+
+bool ArchiveReader::list(const QString& archivePath, std::vector<ArchiveMember>& members, bool* truncated)
+{
+    members.clear();
+    if (truncated)
+        *truncated = false;
+    switch (kindOf(archivePath)) {
+    case Kind::Zip:
+        return listZip(archivePath, members);
+    case Kind::Tar:
+        return listTar(archivePath, members, truncated);
+    default:
+        return false;
+    }
+}
+
+bool ArchiveReader::listZip(const QString& archivePath, std::vector<ArchiveMember>& members)
+{
+    QFile file(archivePath);
+    if (!file.open(QIODevice::ReadOnly))
+        return false;
+    const auto fileSize = file.size();
+
+    // The end of central directory record: 22 bytes and a comment of up to 64 KB
+    const auto tailLen = std::min<qint64>(fileSize, 22 + 0xffff);
+    if (!file.seek(fileSize - tailLen))
+        return false;
+    const auto tail = file.read(tailLen);
+    qsizetype eocd = tail.size() - 22;
+    while (eocd >= 0 && std::memcmp(tail.constData() + eocd, "PK\x05\x06", 4) != 0)
+        --eocd;
+    if (eocd < 0)
+        return false;
+    const auto* rec = tail.constData() + eocd;
+    auto nbrEntries = readLE(rec + 10, 2);
+    auto dirSize = readLE(rec + 12, 4);
+    auto dirOffset = readLE(rec + 16, 4);
+    if (nbrEntries == 0xffff || dirSize == 0xffffffff || dirOffset == 0xffffffff) {
+        // zip64: its end of central directory record is found through a locator
+        if (eocd < 20 || std::memcmp(rec - 20, "PK\x06\x07", 4) != 0)
+            return false;
+        if (!file.seek(qint64(readLE(rec - 20 + 8, 8))))
+            return false;
+        const auto rec64 = file.read(56);
+        if (rec64.size() < 56 || std::memcmp(rec64.constData(), "PK\x06\x06", 4) != 0)
+            return false;
+        nbrEntries = readLE(rec64.constData() + 32, 8);
+        dirSize = readLE(rec64.constData() + 40, 8);
+        dirOffset = readLE(rec64.constData() + 48, 8);
+    }
+    if (dirSize > quint64(MAX_ZIP_DIRECTORY_SIZE) || dirOffset + dirSize > quint64(fileSize))
+        return false;
+    if (!file.seek(qint64(dirOffset)))
+        return false;
+    const auto dir = file.read(qint64(dirSize));
+    if (dir.size() != qsizetype(dirSize))
+        return false;
+
+    members.reserve(size_t(std::min<quint64>(nbrEntries, dirSize / 46)));
+    const auto* p = dir.constData();
+    const auto* dirEnd = p + dir.size();
+    while (dirEnd - p >= 46 && std::memcmp(p, "PK\x01\x02", 4) == 0) {
+        const auto flags = readLE(p + 8, 2);
+        const auto method = readLE(p + 10, 2);
+        const auto nameLen = std::ptrdiff_t(readLE(p + 28, 2));
+        const auto extraLen = std::ptrdiff_t(readLE(p + 30, 2));
+        const auto commentLen = std::ptrdiff_t(readLE(p + 32, 2));
+        if (dirEnd - p < 46 + nameLen + extraLen + commentLen)
+            break;
+        ArchiveMember member;
+        member.archivePath = archivePath;
+        // Names are UTF-8 (flag bit 11) or, in old archives, mostly ASCII
+        const auto rawName = QString::fromUtf8(p + 46, nameLen);
+        member.isDir = rawName.endsWith(u'/');
+        member.name = cleanName(rawName);
+        member.compressedSize = readLE(p + 20, 4);
+        member.size = readLE(p + 24, 4);
+        member.offset = readLE(p + 42, 4);
+        member.mtime = dosTimeToMsecs(readLE(p + 12, 2), readLE(p + 14, 2));
+        member.deflated = method == 8;
+        member.readable = !(flags & 1) && (method == 0 || method == 8);
+        // Extra fields: zip64 sizes and offset, Unix modification time
+        const auto* extra = p + 46 + nameLen;
+        const auto* extraEnd = extra + extraLen;
+        while (extraEnd - extra >= 4) {
+            const auto id = readLE(extra, 2);
+            const auto len = std::ptrdiff_t(readLE(extra + 2, 2));
+            const auto* field = extra + 4;
+            if (extraEnd - field < len)
+                break;
+            if (id == 0x0001) {
+                // Only the values that are 0xffffffff above, in this order
+                quint64* const values[] = { &member.size, &member.compressedSize, &member.offset };
+                std::ptrdiff_t at = 0;
+                for (auto* value : values) {
+                    if (*value == 0xffffffff && at + 8 <= len) {
+                        *value = readLE(field + at, 8);
+                        at += 8;
+                    }
+                }
+            }
+            else if (id == 0x5455 && len >= 5 && (field[0] & 1)) {
+                member.mtime = qint64(readLE(field + 1, 4)) * 1000;
+            }
+            extra = field + len;
+        }
+        p += 46 + nameLen + extraLen + commentLen;
+        if (!member.name.isEmpty())
+            members.push_back(std::move(member));
+    }
+    return true;
+}
+
+bool ArchiveReader::listTar(const QString& archivePath, std::vector<ArchiveMember>& members, bool* truncated)
+{
+    QFile file(archivePath);
+    if (!file.open(QIODevice::ReadOnly))
+        return false;
+    const auto fileSize = file.size();
+    char header[TAR_BLOCK_SIZE];
+    qint64 pos = 0;
+    QString longName;  // of the next member (GNU 'L' or pax header)
+    std::optional<quint64> paxSize;  // e.g. of a member over 8 GB, whose header size may be 0
+    qint64 paxMtime = -1;
+    while (pos + TAR_BLOCK_SIZE <= fileSize) {
+        if (!file.seek(pos) || file.read(header, TAR_BLOCK_SIZE) != TAR_BLOCK_SIZE)
+            return false;
+        if (header[0] == '\0')
+            break;  // end of archive (zero blocks)
+        if (!tarChecksumOk(header)) {
+            // Not a tar archive, or damaged: the members before are listed
+            if (truncated)
+                *truncated = !members.empty();
+            return !members.empty();
+        }
+        auto size = tarNumber(header + 124, 12);
+        const auto type = header[156];
+        // The pax size is that of the member after the pax header
+        if (paxSize && type != 'L' && type != 'x')
+            size = *paxSize;
+        const auto dataPos = pos + TAR_BLOCK_SIZE;
+        pos = dataPos + qint64((size + TAR_BLOCK_SIZE - 1) / TAR_BLOCK_SIZE) * TAR_BLOCK_SIZE;
+        if (type == 'L' || type == 'x') {
+            // Long name (or pax records) of the next member, in its data
+            const auto dataLen = std::min<quint64>(size, 1024 * 1024);
+            if (!file.seek(dataPos))
+                return false;
+            const auto data = file.read(qint64(dataLen));
+            if (type == 'L')
+                longName = QString::fromUtf8(data.constData(), qsizetype(strnlen(data.constData(), size_t(data.size()))));
+            else
+                parsePax(data, longName, paxSize, paxMtime);
+            continue;
+        }
+        ArchiveMember member;
+        member.archivePath = archivePath;
+        auto name = longName;
+        if (name.isEmpty()) {
+            name = tarString(header, 100);
+            const auto prefix = tarString(header + 345, 155);
+            if (std::memcmp(header + 257, "ustar", 5) == 0 && !prefix.isEmpty())
+                name = prefix + u'/' + name;
+        }
+        member.isDir = type == '5' || name.endsWith(u'/');
+        member.name = cleanName(name);
+        member.size = member.isDir ? 0 : size;
+        member.compressedSize = member.size;
+        member.mtime = paxMtime >= 0 ? paxMtime : qint64(tarNumber(header + 136, 12)) * 1000;
+        member.offset = quint64(dataPos);
+        longName.clear();
+        paxSize.reset();
+        paxMtime = -1;
+        // Regular files and folders only (not links, devices, etc.)
+        const auto regular = type == '0' || type == '\0' || type == '7';
+        if ((regular || member.isDir) && !member.name.isEmpty())
+            members.push_back(std::move(member));
+    }
+    // The data of the last member goes past the end of the file
+    if (truncated && pos > fileSize)
+        *truncated = true;
+    return true;
+}
+
+void ArchiveReader::openMember(ContentReader& reader, const ArchiveMember& member)
+{
+    if (member.isDir || !member.readable) {
+        reader.setRange(0, 0);
+        return;
+    }
+    if (kindOf(member.archivePath) == Kind::Tar) {
+        reader.setRange(qint64(member.offset), qint64(member.size));
+        return;
+    }
+    // zip: the data follows the local header, whose name and extra field
+    // lengths may differ from those in the central directory
+    QFile file(member.archivePath);
+    char local[30];
+    if (!file.open(QIODevice::ReadOnly) || !file.seek(qint64(member.offset)) ||
+        file.read(local, sizeof(local)) != qint64(sizeof(local)) ||
+        std::memcmp(local, "PK\x03\x04", 4) != 0) {
+        reader.setRange(0, 0);
+        return;
+    }
+    const auto dataPos = member.offset + sizeof(local) + readLE(local + 26, 2) + readLE(local + 28, 2);
+    reader.setRange(qint64(dataPos), qint64(member.compressedSize),
+                    member.deflated ? Decompressor::Format::Deflate : Decompressor::Format::None);
+}
+
+}
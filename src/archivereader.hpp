@@ -0,0 +1,75 @@
+#pragma once
+//
+// Copyright (c) Milivoj (Mike) DAVIDOV
+//
+// THIS SOFTWARE IS PROVIDED "AS IS" WITHOUT WARRANTY OF ANY KIND,
+// EITHER EXPRESSED OR IMPLIED, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+// WARRANTIES OF MERCHANTABILITY AND/OR FITNESS FOR A PARTICULAR PURPOSE.
+//
+
+#include "contentreader.hpp"
+#include <cstddef>
+#include <vector>
+#include <QString>
+
+namespace mmd
+{
+/// One file or folder in a zip or tar archive
+struct ArchiveMember
+{
+    QString archivePath;  // of the archive file
+    QString name;         // path in the archive, '/' separators, no trailing '/'
+    bool isDir{ false };
+    bool readable{ true };     // false if encrypted, or compressed by an unknown method
+    quint64 size{ 0 };         // uncompressed
+    qint64 mtime{ -1 };        // msec since epoch, -1 if not known
+    quint64 offset{ 0 };       // zip: of the local header, tar: of the data
+    quint64 compressedSize{ 0 };
+    bool deflated{ false };    // zip: deflate, otherwise stored
+};
+
+/// @brief Lists the members of zip (and jar) and tar archives, and reads
+/// their contents, without extracting anything:
+/// - zip: only the central directory at the end of the file is read to list
+///   the members (zip64 included); a member's data is found through its
+///   local header when it is read, and inflated on the fly (ContentReader).
+/// - tar (ustar, GNU and pax long names): the 512 byte headers are read,
+///   seeking over the data in between; member data is stored as is.
+///   Compressed tar files (.tar.gz etc.) are not listed, as that would
+///   decompress them whole.
+/// So listing an archive never decompresses anything.
+/// A member is shown as "archive.zip!/path/in/zip" (see memberPath()).
+/// Stateless; the functions can be called by several threads.
+/// @author Milivoj (Mike) DAVIDOV
+///
+class ArchiveReader
+{
+public:
+    enum class Kind { None, Zip, Tar };
+
+    /// By the file name extension (.zip, .jar, .tar), case-insensitive
+    static Kind kindOf(const QString& fileName);
+    static Kind kindOf(const char* fileName, std::size_t len);
+
+    /// "archive!/name"
+    static QString memberPath(const QString& archivePath, const QString& name);
+    /// The archive of a member path, or @p path itself if not in an archive
+    static QString diskPath(const QString& path);
+    static bool isMemberPath(const QString& path);
+
+    /// @brief Lists the members of the archive at @p archivePath.
+    /// @p truncated (optional) is set if a tar archive is damaged or cut short:
+    /// only the members before that are listed.
+    /// @return false if it could not be read (or is not a zip / tar archive).
+    static bool list(const QString& archivePath, std::vector<ArchiveMember>& members, bool* truncated = nullptr);
+
+    /// Sets @p reader (opened on the archive) to read the member's contents;
+    /// nothing is read if the member cannot be.
+    static void openMember(ContentReader& reader, const ArchiveMember& member);
+
+private:
+    static bool listZip(const QString& archivePath, std::vector<ArchiveMember>& members);
+    static bool listTar(const QString& archivePath, std::vector<ArchiveMember>& members, bool* truncated);
+};
+
+}
@@ -0,0 +1,123 @@
+#pragma once
+//
+// Copyright (c) Milivoj (Mike) DAVIDOV
+//
+// THIS SOFTWARE IS PROVIDED "AS IS" WITHOUT WARRANTY OF ANY KIND,
+// EITHER EXPRESSED OR IMPLIED, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+// WARRANTIES OF MERCHANTABILITY AND/OR FITNESS FOR A PARTICULAR PURPOSE.
+//
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <mutex>
+#include <optional>
+#include <utility>
+#include <vector>
+
+namespace mmd
+{
+/// @brief Multi-producer, multi-consumer FIFO of at most @c capacity items,
+/// connecting two stages of a pipeline: a producer waits while the queue
+/// is full (so a slow consumer stage slows the producer stage down instead
+/// of letting the queue grow), a consumer waits while it is empty.
+/// close() ends the stream: consumers get the remaining items, then nothing.
+/// Waiting also ends when the @p stopped flag becomes true
+/// (checked at least every 50 ms), and pop() when its @p wake flag does.
+/// @author Milivoj (Mike) DAVIDOV
+///
+template <typename T>
+class BoundedQueue
+{
+public:
+    explicit BoundedQueue(std::size_t capacity)
+        : capacity_(capacity > 0 ? capacity : 1)
+    {
+    }
+
+    std::size_t capacity() const { return capacity_; }
+
+    std::size_t size() const {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return items_.size();
+    }
+
+    /// Waits for room, then queues @p item.
+    /// @return false (and drops the item) if closed or stopped
+    bool push(T item, const std::atomic<bool>& stopped) {
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            while (!closed_ && items_.size() >= capacity_) {
+                if (stopped)
+                    return false;
+                notFull_.wait_for(lock, std::chrono::milliseconds(50));
+            }
+            if (closed_)
+                return false;
+            items_.push_back(std::move(item));
+        }
+        notEmpty_.notify_one();
+        return true;
+    }
+
+    /// Waits for an item.
+    /// @return nothing when closed and empty, or stopped, or woken (see ended())
+    std::optional<T> pop(const std::atomic<bool>& stopped, const std::atomic<bool>* wake = nullptr) {
+        std::optional<T> item;
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            while (items_.empty()) {
+                if (closed_ || stopped || (wake && *wake))
+                    return std::nullopt;
+                notEmpty_.wait_for(lock, std::chrono::milliseconds(50));
+            }
+            item = std::move(items_.front());
+            items_.pop_front();
+        }
+        notFull_.notify_one();
+        return item;
+    }
+
+    /// Moves all the queued items to @p out, without waiting.
+    /// @return the number of items moved
+    std::size_t popAll(std::vector<T>& out) {
+        std::size_t n = 0;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            n = items_.size();
+            for (auto& item : items_)
+                out.push_back(std::move(item));
+            items_.clear();
+        }
+        if (n > 0)
+            notFull_.notify_all();
+        return n;
+    }
+
+    /// Closed and empty: pop() returns nothing from now on.
+    bool ended() const {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return closed_ && items_.empty();
+    }
+
+    void close() {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            closed_ = true;
+        }
+        notEmpty_.notify_all();
+        notFull_.notify_all();
+    }
+
+private:
+    const std::size_t capacity_;
+    mutable std::mutex mutex_;
+    std::condition_variable notEmpty_;
+    std::condition_variable notFull_;
+    std::deque<T> items_;
+    bool closed_{ false };
+};
+
+}
@@ -27,6 +27,19 @@ namespace mmd
 #endif
 
     const QString Cfg::origDirPathKey       = QObject::tr("OrigDirPath");
+    const QString Cfg::useScanIndexKey      = QObject::tr("UseScanIndex");
+    const QString Cfg::useContentIndexKey   = QObject::tr("UseContentIndex");
+    const QString Cfg::spareCacheKey        = QObject::tr("SpareCache");
+    const QString Cfg::directReadMinSizeKey = QObject::tr("DirectReadMinSize");
+    const QString Cfg::maxDecompressedSizeKey = QObject::tr("MaxDecompressedSize");
+    const QString Cfg::contentThreadsKey = QObject::tr("ContentThreads");
+    const QString Cfg::scanThreadsKey = QObject::tr("ScanThreads");
+    const QString Cfg::readMemoryBudgetKey = QObject::tr("ReadMemoryBudget");
+    const QString Cfg::qtDirListingKey = QObject::tr("QtDirListing");
+    const QString Cfg::uringStatKey = QObject::tr("UringStat");
+    const QString Cfg::syncStatKey = QObject::tr("SyncStat");
+    const QString Cfg::diskOrderReadsKey = QObject::tr("DiskOrderReads");
+    const QString Cfg::unorderedReadsKey = QObject::tr("UnorderedReads");
 
 //    const QString Cfg::deepDelKey           = QObject::tr("DeepDel");
 
@@ -200,6 +200,14 @@ QT_END_NAMESPACE
 #define eCod_EXCL_FOLDERS_BY_NAME_TIP   tr("Exclude folders whose name equals this text (case insensitive).")
 #define eCod_EXCL_FILES_BY_CONTENT_TIP  tr("Exclude files that contain this text.")
 #define eCod_EXCL_HIDDEN_ITEMS          tr("Exclude hidden folders, files and shortcuts. Note: ALL sub-folders, files and shortcuts (hidden or not) under a hidden folder are also excluded.")
+#define eCod_SEARCH_BINARY_FILES_TIP    tr("Also search for words in binary files (executables, libraries, archives, images, databases, etc.), which are skipped otherwise.")
+#define eCod_WHOLE_WORDS_TIP            tr("Only match whole words: the characters before and after a search word (or regular expression match) must not be letters, digits or '_'.")
+#define eCod_REGEX_TIP                  tr("Search words and file/folder names are regular expressions (names ignore the case of letters, and match anywhere in the name).")
+#define eCod_SEARCH_COMPRESSED_TIP      tr("Search for words in the decompressed contents of gzip, zstd and xz compressed files (e.g. .log.gz, .zst, .xz), up to MaxDecompressedSize MB each (in the settings file, 0 means 1 GB).")
+#define eCod_SEARCH_ARCHIVES_TIP        tr("Also search inside zip, jar and tar archives, without extracting them: their files and folders are listed as archive.zip!/path/in/zip.")
+#define eCod_USE_SCAN_INDEX_TIP         tr("Remember the contents of searched folders, and which files matched the searched words, on disk, so that a repeated search only reads the folders and files that changed since.")
+#define eCod_SPARE_CACHE_TIP            tr("Do not leave the searched files in the file system cache (Linux), so that a big search does not evict the files other programs use. Files of at least DirectReadMinSize MB (in the settings file, 0 means none) are read around the cache.")
+#define eCod_USE_CONTENT_INDEX_TIP      tr("Remember the words (trigrams) in searched files on disk, so that a repeated word search only reads the files that may contain the words, or that changed since. The first search reads every file to its end. Which files matched is also remembered, for the session.")
 #define eCod_SHOW_EXCL_OPTS_TIP         tr("Hide exclusion options.")
 #define eCod_HIDE_EXCL_OPTS_TIP         tr("Show exclusion options.")
 #define eCod_BROWSE_FOLDERS_TIP         tr("Use the system dialog to select a folder, set it as the search folder, and search.")
@@ -220,6 +228,19 @@ namespace mmd
         static const bool deepDel;
 
         static const QString origDirPathKey;
+        static const QString useScanIndexKey;
+        static const QString useContentIndexKey;
+        static const QString spareCacheKey;
+        static const QString directReadMinSizeKey;
+        static const QString maxDecompressedSizeKey;
+        static const QString contentThreadsKey;
+        static const QString scanThreadsKey;
+        static const QString readMemoryBudgetKey;
+        static const QString qtDirListingKey;
+        static const QString uringStatKey;
+        static const QString syncStatKey;
+        static const QString diskOrderReadsKey;
+        static const QString unorderedReadsKey;
 
 //        static const QString deepDelKey;
 
@@ -0,0 +1,670 @@
+//
+// Copyright (c) Milivoj (Mike) DAVIDOV
+//
+// THIS SOFTWARE IS PROVIDED "AS IS" WITHOUT WARRANTY OF ANY KIND,
+// EITHER EXPRESSED OR IMPLIED, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+// WARRANTIES OF MERCHANTABILITY AND/OR FITNESS FOR A PARTICULAR PURPOSE.
+//
+
+#include "contentindex.hpp"
+#include "decompressor.hpp"
+#include "scanindex.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <iterator>
+#include <span>
+#include <QDataStream>
+#include <QDateTime>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QSaveFile>
+#include <QSysInfo>
+#include <QDebug>
+#if !defined(Q_OS_WIN)
+#include <sys/stat.h>
+#endif
+
+namespace mmd
+{
+namespace
+{
+constexpr quint32 INDEX_MAGIC = 0x4D534349;  // "MSCI"
+constexpr quint32 INDEX_VERSION = 2;
+constexpr quint32 SEGMENT_MAGIC = 0x4D534350;  // "MSCP", in the native byte order
+
+// As for folders (see ScanIndex): a file indexed within that long of its
+// last change may change again without a new mtime, so it is not trusted.
+constexpr qint64 MTIME_RESOLUTION_MS = 2000;
+
+constexpr quint32 NO_ID = 0xffffffff;
+
+std::vector<std::uint64_t>& seenTrigrams()
+{
+    // One bit per trigram; only the bits of the current TrigramSet are set
+    thread_local std::vector<std::uint64_t> bits(std::size_t(1) << (24 - 6), 0);
+    return bits;
+}
+
+/// A segment file: the posting lists (file ids) one after another, then the
+/// directory of the lists (sorted by trigram), then the footer
+struct SegmentEntry
+{
+    quint32 trigram;
+    quint32 nbrIds;
+    quint64 offset;
+};
+struct SegmentFooter
+{
+    quint32 magic;
+    quint32 nbrLists;
+    quint64 directoryOffset;
+};
+static_assert(sizeof(SegmentEntry) == 16 && sizeof(SegmentFooter) == 16);
+
+/// Writes a segment file, one list at a time, in trigram order
+class SegmentWriter
+{
+public:
+    explicit SegmentWriter(const QString& path) : file(path) { ok = file.open(QIODevice::WriteOnly); }
+
+    void add(quint32 trigram, const std::vector<quint32>& ids) {
+        if (!ok || ids.empty())
+            return;
+        directory.push_back({ trigram, quint32(ids.size()), offset });
+        write(ids.data(), ids.size() * sizeof(quint32));
+    }
+    bool commit() {
+        if (!ok)
+            return false;
+        // The directory aligned to its entries, in the mapped file
+        static const char padding[sizeof(SegmentEntry)] = {};
+        write(padding, std::size_t((sizeof(SegmentEntry) - offset % sizeof(SegmentEntry)) % sizeof(SegmentEntry)));
+        const SegmentFooter footer{ SEGMENT_MAGIC, quint32(directory.size()), offset };
+        write(directory.data(), directory.size() * sizeof(SegmentEntry));
+        write(&footer, sizeof(footer));
+        return ok && file.commit();
+    }
+
+private:
+    void write(const void* data, std::size_t len) {
+        ok = ok && file.write(static_cast<const char*>(data), qint64(len)) == qint64(len);
+        offset += len;
+    }
+
+    QSaveFile file;
+    std::vector<SegmentEntry> directory;
+    quint64 offset{ 0 };
+    bool ok{ false };
+};
+
+/// The ids of @p ids that are also in @p list (both sorted), appended to @p out
+void intersectSorted(const std::vector<quint32>& ids, std::span<const quint32> list, std::vector<quint32>& out)
+{
+    if (ids.size() * 16 < list.size()) {
+        // Much shorter: each one looked up, so most of the (mapped) list is not read
+        auto from = list.begin();
+        for (const auto id : ids) {
+            from = std::lower_bound(from, list.end(), id);
+            if (from == list.end())
+                break;
+            if (*from == id)
+                out.push_back(id);
+        }
+        return;
+    }
+    std::set_intersection(ids.begin(), ids.end(), list.begin(), list.end(), std::back_inserter(out));
+}
+
+quint64 elapsedNs(std::chrono::steady_clock::time_point start)
+{
+    return quint64(std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now() - start).count());
+}
+}
+
+FileKey FileKey::of(const QString& path)
+{
+    FileKey key;
+#if defined(Q_OS_WIN)
+    const QFileInfo info(path);
+    if (!info.exists())
+        return key;
+    key.size = info.size();
+    key.mtime = info.lastModified().toMSecsSinceEpoch();
+#else
+    struct stat st;
+    if (::stat(QFile::encodeName(path).constData(), &st) != 0)
+        return key;
+    key.device = quint64(st.st_dev);
+    key.inode = quint64(st.st_ino);
+    key.size = qint64(st.st_size);
+#if defined(Q_OS_DARWIN)
+    key.mtime = qint64(st.st_mtimespec.tv_sec) * 1000 + st.st_mtimespec.tv_nsec / 1000000;
+#else
+    key.mtime = qint64(st.st_mtim.tv_sec) * 1000 + st.st_mtim.tv_nsec / 1000000;
+#endif
+#endif
+    return key;
+}
+
+
+TrigramSet::~TrigramSet()
+{
+    clearSeen();
+}
+
+void TrigramSet::add(const char* data, std::size_t len)
+{
+    const auto start = std::chrono::steady_clock::now();
+    auto& seen = seenTrigrams();
+    auto w = window;
+    auto n = nbrInWindow;
+    for (std::size_t i = 0; i < len; ++i) {
+        auto c = static_cast<unsigned char>(data[i]);
+        if (c >= 'A' && c <= 'Z')
+            c = static_cast<unsigned char>(c + ('a' - 'A'));
+        w = ((w << 8) | c) & 0xffffff;
+        if (n < 2) {
+            ++n;
+            continue;
+        }
+        auto& bits = seen[w >> 6];
+        const auto bit = std::uint64_t(1) << (w & 63);
+        if (!(bits & bit)) {
+            bits |= bit;
+            trigrams.push_back(w);
+        }
+    }
+    window = w;
+    nbrInWindow = n;
+    bytes += len;
+    ns += elapsedNs(start);
+}
+
+void TrigramSet::clearSeen()
+{
+    if (trigrams.empty())
+        return;
+    auto& seen = seenTrigrams();
+    for (const auto t : trigrams)
+        seen[t >> 6] = 0;
+}
+
+std::vector<quint32> TrigramSet::takeSorted()
+{
+    clearSeen();
+    std::vector<quint32> sorted;
+    sorted.swap(trigrams);
+    std::sort(sorted.begin(), sorted.end());
+    return sorted;
+}
+
+
+/// A mapped segment file (see SegmentWriter)
+class ContentIndex::Segment
+{
+public:
+    Segment(const QString& path, quint32 segmentNumber)
+        : file(path)
+        , number(segmentNumber)
+    {
+    }
+    ~Segment() {
+        if (data)
+            file.unmap(const_cast<uchar*>(data));
+    }
+    Segment(const Segment&) = delete;
+    Segment& operator=(const Segment&) = delete;
+
+    quint32 fileNumber() const { return number; }
+    QString path() const { return file.fileName(); }
+
+    bool open() {
+        if (!file.open(QIODevice::ReadOnly))
+            return false;
+        const auto size = file.size();
+        if (size < qint64(sizeof(SegmentFooter)))
+            return false;
+        data = file.map(0, size);
+        if (!data)
+            return false;
+        SegmentFooter footer;
+        std::memcpy(&footer, data + size - qint64(sizeof(footer)), sizeof(footer));
+        if (footer.magic != SEGMENT_MAGIC || footer.directoryOffset % sizeof(SegmentEntry) != 0 ||
+            footer.directoryOffset + quint64(footer.nbrLists) * sizeof(SegmentEntry) + sizeof(footer) != quint64(size))
+            return false;
+        directory = { reinterpret_cast<const SegmentEntry*>(data + footer.directoryOffset), footer.nbrLists };
+        listsSize = footer.directoryOffset;
+        return true;
+    }
+
+    /// The ids of @p trigram, sorted
+    std::span<const quint32> list(quint32 trigram) const {
+        const auto it = std::lower_bound(directory.begin(), directory.end(), trigram,
+            [](const SegmentEntry& entry, quint32 t) { return entry.trigram < t; });
+        if (it == directory.end() || it->trigram != trigram || it->offset % sizeof(quint32) != 0 ||
+            it->offset + quint64(it->nbrIds) * sizeof(quint32) > listsSize)
+            return {};
+        return { reinterpret_cast<const quint32*>(data + it->offset), it->nbrIds };
+    }
+    std::span<const SegmentEntry> lists() const { return directory; }
+
+private:
+    QFile file;
+    const quint32 number;
+    const uchar* data{ nullptr };
+    std::span<const SegmentEntry> directory;
+    quint64 listsSize{ 0 };
+};
+
+
+ContentIndex::ContentIndex(const QString& indexFilePath)
+    : filePath(indexFilePath)
+{
+}
+
+ContentIndex::~ContentIndex() = default;
+
+QString ContentIndex::defaultFilePath()
+{
+    return QFileInfo(ScanIndex::defaultFilePath()).absolutePath() + QStringLiteral("/contentindex.bin");
+}
+
+QString ContentIndex::segmentPath(quint32 number) const
+{
+    return filePath + QStringLiteral(".%1.postings").arg(number);
+}
+
+std::vector<quint32> ContentIndex::trigramsOf(const char* utf8, std::size_t len)
+{
+    TrigramSet set;
+    set.add(utf8, len);
+    return set.takeSorted();
+}
+
+void ContentIndex::load()
+{
+    std::lock_guard<std::mutex> fileLock(fileMutex);
+    if (loaded)
+        return;
+    loaded = true;
+    QFile file(filePath);
+    if (!file.open(QIODevice::ReadOnly))
+        return;
+    QDataStream in(&file);
+    in.setVersion(QDataStream::Qt_6_0);
+    quint32 magic = 0;
+    quint32 version = 0;
+    quint8 byteOrder = 0;
+    quint32 loadedNextId = 0;
+    quint32 loadedNextSegment = 0;
+    quint32 nbrSegments = 0;
+    in >> magic >> version >> byteOrder >> loadedNextId >> loadedNextSegment >> nbrSegments;
+    if (magic != INDEX_MAGIC || version != INDEX_VERSION || byteOrder != quint8(QSysInfo::ByteOrder))
+        return;
+
+    std::vector<std::unique_ptr<Segment>> loadedSegments;
+    for (quint32 s = 0; s < nbrSegments && in.status() == QDataStream::Ok; ++s) {
+        quint32 number = 0;
+        in >> number;
+        auto segment = std::make_unique<Segment>(segmentPath(number), number);
+        if (number >= loadedNextSegment || !segment->open())
+            in.setStatus(QDataStream::ReadCorruptData);
+        loadedSegments.push_back(std::move(segment));
+    }
+    quint64 nbrFiles = 0;
+    in >> nbrFiles;
+    std::map<QString, FileRecord> loadedFiles;
+    for (quint64 f = 0; f < nbrFiles && in.status() == QDataStream::Ok; ++f) {
+        QString path;
+        FileRecord rec;
+        in >> path >> rec.key.device >> rec.key.inode >> rec.key.size >> rec.key.mtime
+           >> rec.indexedAt >> rec.id >> rec.flags >> rec.maxDecompressed;
+        if (rec.id >= loadedNextId)
+            in.setStatus(QDataStream::ReadCorruptData);
+        loadedFiles.emplace_hint(loadedFiles.end(), std::move(path), rec);
+    }
+    if (in.status() != QDataStream::Ok) {
+        qDebug() << "Ignoring corrupt content index" << filePath;
+        return;
+    }
+    std::unique_lock<std::shared_mutex> lock(mutex);
+    files = std::move(loadedFiles);
+    nextId = loadedNextId;
+    segments = std::move(loadedSegments);
+    nextSegment = loadedNextSegment;
+}
+
+bool ContentIndex::save()
+{
+    std::lock_guard<std::mutex> fileLock(fileMutex);
+    std::unique_lock<std::shared_mutex> lock(mutex);
+    if (!dirty)
+        return true;
+    std::vector<std::unique_lock<std::mutex>> shardLocks;
+    for (auto& shard : shards)
+        shardLocks.emplace_back(shard.mutex);
+    if (!writeMemoryPostings())
+        return false;
+    // Re-indexed files left their old ids in the posting lists
+    if ((segments.size() > MAX_SEGMENTS || quint64(files.size()) * 2 < nextId) && !mergeSegments())
+        return false;
+
+    QDir().mkpath(QFileInfo(filePath).absolutePath());
+    QSaveFile file(filePath);
+    if (!file.open(QIODevice::WriteOnly))
+        return false;
+    QDataStream out(&file);
+    out.setVersion(QDataStream::Qt_6_0);
+    out << INDEX_MAGIC << INDEX_VERSION << quint8(QSysInfo::ByteOrder) << nextId << nextSegment
+        << quint32(segments.size());
+    for (const auto& segment : segments)
+        out << segment->fileNumber();
+    out << quint64(files.size());
+    for (const auto& [path, rec] : files) {
+        out << path << rec.key.device << rec.key.inode << rec.key.size << rec.key.mtime
+            << rec.indexedAt << rec.id << rec.flags << rec.maxDecompressed;
+    }
+    if (out.status() != QDataStream::Ok || !file.commit())
+        return false;
+    dirty = false;
+    removeUnusedSegments();
+    return true;
+}
+
+bool ContentIndex::writeMemoryPostings()
+{
+    if (nbrMemoryPostings == 0)
+        return true;
+    std::vector<std::pair<quint32, std::vector<quint32>*>> lists;
+    for (auto& shard : shards) {
+        for (auto& [trigram, ids] : shard.lists)
+            lists.push_back({ trigram, &ids });
+    }
+    std::sort(lists.begin(), lists.end());
+    const auto number = nextSegment;
+    SegmentWriter writer(segmentPath(number));
+    for (auto& [trigram, ids] : lists) {
+        // Appended by several readers, so maybe not in order
+        if (!std::is_sorted(ids->begin(), ids->end()))
+            std::sort(ids->begin(), ids->end());
+        writer.add(trigram, *ids);
+    }
+    if (!writer.commit())
+        return false;
+    auto segment = std::make_unique<Segment>(segmentPath(number), number);
+    if (!segment->open())
+        return false;
+    segments.push_back(std::move(segment));
+    ++nextSegment;
+    for (auto& shard : shards)
+        shard.lists.clear();
+    nbrMemoryPostings = 0;
+    return true;
+}
+
+bool ContentIndex::mergeSegments()
+{
+    // The live ids are renumbered 0..n-1, in the same order, and the others dropped
+    std::vector<quint32> liveIds;
+    liveIds.reserve(files.size());
+    for (const auto& [path, rec] : files)
+        liveIds.push_back(rec.id);
+    std::sort(liveIds.begin(), liveIds.end());
+    std::vector<quint32> newIds(nextId, NO_ID);
+    for (std::size_t i = 0; i < liveIds.size(); ++i)
+        newIds[liveIds[i]] = quint32(i);
+
+    // One list at a time, from all the segments (their directories are sorted)
+    const auto number = nextSegment;
+    SegmentWriter writer(segmentPath(number));
+    std::vector<std::size_t> at(segments.size(), 0);
+    std::vector<quint32> ids;
+    for (;;) {
+        auto trigram = NO_ID;
+        auto more = false;
+        for (std::size_t s = 0; s < segments.size(); ++s) {
+            const auto lists = segments[s]->lists();
+            if (at[s] < lists.size()) {
+                trigram = more ? std::min(trigram, lists[at[s]].trigram) : lists[at[s]].trigram;
+                more = true;
+            }
+        }
+        if (!more)
+            break;
+        ids.clear();
+        for (std::size_t s = 0; s < segments.size(); ++s) {
+            const auto lists = segments[s]->lists();
+            if (at[s] >= lists.size() || lists[at[s]].trigram != trigram)
+                continue;
+            ++at[s];
+            for (const auto id : segments[s]->list(trigram)) {
+                if (id < newIds.size() && newIds[id] != NO_ID)
+                    ids.push_back(newIds[id]);
+            }
+        }
+        // An id stored while a segment was written may be in the next one
+        if (!std::is_sorted(ids.begin(), ids.end()))
+            std::sort(ids.begin(), ids.end());
+        writer.add(trigram, ids);
+    }
+    if (!writer.commit())
+        return false;
+    auto segment = std::make_unique<Segment>(segmentPath(number), number);
+    if (!segment->open())
+        return false;
+    segments.clear();
+    segments.push_back(std::move(segment));
+    ++nextSegment;
+    for (auto& [path, rec] : files)
+        rec.id = newIds[rec.id];
+    nextId = quint32(liveIds.size());
+    return true;
+}
+
+void ContentIndex::removeUnusedSegments()
+{
+    // Merged, cleared, or written by a session that did not save
+    const QFileInfo index(filePath);
+    const auto list = QDir(index.absolutePath()).entryInfoList({ index.fileName() + QStringLiteral(".*.postings") }, QDir::Files);
+    for (const auto& info : list) {
+        const auto used = std::any_of(segments.begin(), segments.end(),
+            [&info](const auto& segment) { return QFileInfo(segment->path()).fileName() == info.fileName(); });
+        if (!used)
+            QFile::remove(info.absoluteFilePath());
+    }
+}
+
+void ContentIndex::flushMemoryPostings()
+{
+    // Not while being saved (or flushed by another reader)
+    std::unique_lock<std::mutex> fileLock(fileMutex, std::try_to_lock);
+    if (!fileLock.owns_lock())
+        return;
+    std::unique_lock<std::shared_mutex> lock(mutex);
+    std::vector<std::unique_lock<std::mutex>> shardLocks;
+    for (auto& shard : shards)
+        shardLocks.emplace_back(shard.mutex);
+    if (nbrMemoryPostings >= MAX_MEMORY_POSTINGS && !writeMemoryPostings())
+        qDebug() << "Could not write the content index postings" << segmentPath(nextSegment);
+}
+
+void ContentIndex::clear()
+{
+    std::unique_lock<std::shared_mutex> lock(mutex);
+    files.clear();
+    nextId = 0;
+    segments.clear();
+    for (auto& shard : shards) {
+        std::lock_guard<std::mutex> shardLock(shard.mutex);
+        shard.lists.clear();
+    }
+    nbrMemoryPostings = 0;
+    candidates.clear();
+    constrained = false;
+    dirty = true;
+}
+
+std::size_t ContentIndex::listSize(quint32 trigram)
+{
+    std::size_t size = 0;
+    for (const auto& segment : segments)
+        size += segment->list(trigram).size();
+    auto& shard = shards[shardOf(trigram)];
+    std::lock_guard<std::mutex> shardLock(shard.mutex);
+    const auto it = shard.lists.find(trigram);
+    return it == shard.lists.end() ? size : size + it->second.size();
+}
+
+std::vector<quint32> ContentIndex::listOf(quint32 trigram)
+{
+    // The segments have distinct ids, mostly in order
+    std::vector<quint32> ids;
+    for (const auto& segment : segments) {
+        const auto list = segment->list(trigram);
+        ids.insert(ids.end(), list.begin(), list.end());
+    }
+    {
+        auto& shard = shards[shardOf(trigram)];
+        std::lock_guard<std::mutex> shardLock(shard.mutex);
+        if (const auto it = shard.lists.find(trigram); it != shard.lists.end())
+            ids.insert(ids.end(), it->second.begin(), it->second.end());
+    }
+    if (!std::is_sorted(ids.begin(), ids.end()))
+        std::sort(ids.begin(), ids.end());
+    return ids;
+}
+
+void ContentIndex::intersect(std::vector<quint32>& ids, quint32 trigram)
+{
+    std::vector<quint32> result;
+    for (const auto& segment : segments)
+        intersectSorted(ids, segment->list(trigram), result);
+    {
+        auto& shard = shards[shardOf(trigram)];
+        std::lock_guard<std::mutex> shardLock(shard.mutex);
+        if (const auto it = shard.lists.find(trigram); it != shard.lists.end()) {
+            // Appended by several readers, so maybe not in order
+            auto& list = it->second;
+            if (!std::is_sorted(list.begin(), list.end()))
+                std::sort(list.begin(), list.end());
+            intersectSorted(ids, list, result);
+        }
+    }
+    if (!std::is_sorted(result.begin(), result.end()))
+        std::sort(result.begin(), result.end());
+    ids.swap(result);
+}
+
+void ContentIndex::prepare(const Query& query, bool decompress, quint64 maxDecompressedSize, bool inclBinaryFiles)
+{
+    const auto start = std::chrono::steady_clock::now();
+    std::unique_lock<std::shared_mutex> lock(mutex);
+    decompressMode = decompress;
+    maxDecompressed = maxDecompressedSize > 0 ? maxDecompressedSize : Decompressor::DEFAULT_MAX_SIZE;
+    binaryFilesSearched = inclBinaryFiles;
+    candidates.clear();
+    // A group without trigrams (e.g. a word shorter than 3 bytes) lets any file match
+    constrained = !query.groups.empty() &&
+        std::none_of(query.groups.begin(), query.groups.end(), [](const auto& group) { return group.empty(); });
+    if (constrained) {
+        std::vector<quint32> tmp;
+        for (const auto& group : query.groups) {
+            // Only the lists of the query are read, the shortest first, so the
+            // intersection shrinks fast and most of the longer ones is not read
+            std::vector<std::pair<std::size_t, quint32>> bySize;
+            for (const auto trigram : group)
+                bySize.push_back({ listSize(trigram), trigram });
+            std::sort(bySize.begin(), bySize.end());
+            if (bySize.front().first == 0)
+                continue;  // a trigram that no file has
+            auto result = listOf(bySize.front().second);
+            for (std::size_t i = 1; i < bySize.size() && !result.empty(); ++i)
+                intersect(result, bySize[i].second);
+            tmp.clear();
+            std::set_union(candidates.begin(), candidates.end(), result.begin(), result.end(),
+                           std::back_inserter(tmp));
+            candidates.swap(tmp);
+        }
+    }
+    nbrSkipped = 0;
+    nbrIndexed = 0;
+    nbrIndexedBytes = 0;
+    buildNs = 0;
+    queryNs = elapsedNs(start);
+}
+
+ContentIndex::Answer ContentIndex::check(const QString& path, const FileKey& key) const
+{
+    if (!key.isValid())
+        return Answer::Unknown;
+    std::shared_lock<std::shared_mutex> lock(mutex);
+    const auto it = files.find(path);
+    if (it == files.end())
+        return Answer::Unknown;
+    const auto& rec = it->second;
+    if (!(rec.key == key) || rec.indexedAt - key.mtime < MTIME_RESOLUTION_MS ||
+        ((rec.flags & Decompressed) != 0) != decompressMode)
+        return Answer::Unknown;
+    // Decompressed up to a lower cap: the bytes after it were not indexed
+    if (decompressMode && rec.maxDecompressed < maxDecompressed)
+        return Answer::Unknown;
+    if (rec.flags & Binary) {
+        if (binaryFilesSearched)
+            return Answer::Unknown;  // its trigrams were not collected
+        ++nbrSkipped;
+        return Answer::Binary;
+    }
+    if (constrained && !std::binary_search(candidates.begin(), candidates.end(), rec.id)) {
+        ++nbrSkipped;
+        return Answer::NoMatch;
+    }
+    return Answer::Candidate;
+}
+
+void ContentIndex::store(const QString& path, const FileKey& key, TrigramSet& trigrams)
+{
+    if (!key.isValid() || !(trigrams.isComplete() || trigrams.isBinary()))
+        return;
+    const auto start = std::chrono::steady_clock::now();
+    const auto sorted = trigrams.takeSorted();
+    FileRecord rec;
+    rec.key = key;
+    rec.indexedAt = QDateTime::currentMSecsSinceEpoch();
+    {
+        std::unique_lock<std::shared_mutex> lock(mutex);
+        rec.flags = quint8((trigrams.isBinary() ? Binary : 0) | (decompressMode ? Decompressed : 0));
+        rec.maxDecompressed = decompressMode ? maxDecompressed : 0;
+        rec.id = nextId++;
+        // The postings of a previous id of this file are dropped by mergeSegments()
+        files[path] = rec;
+    }
+    // One lock per shard for all of its trigrams
+    std::array<std::vector<quint32>, NBR_SHARDS> byShard;
+    for (const auto trigram : sorted)
+        byShard[shardOf(trigram)].push_back(trigram);
+    for (std::size_t s = 0; s < NBR_SHARDS; ++s) {
+        if (byShard[s].empty())
+            continue;
+        std::lock_guard<std::mutex> shardLock(shards[s].mutex);
+        for (const auto trigram : byShard[s])
+            shards[s].lists[trigram].push_back(rec.id);
+    }
+    dirty = true;
+    ++nbrIndexed;
+    nbrIndexedBytes += trigrams.nbrBytes();
+    buildNs += trigrams.nanoseconds() + elapsedNs(start);
+    // The index of a big first search is built in segments, not all in memory
+    if ((nbrMemoryPostings += sorted.size()) >= MAX_MEMORY_POSTINGS)
+        flushMemoryPostings();
+}
+
+double ContentIndex::buildMbPerSecond() const
+{
+    const auto ns = buildNs.load();
+    return ns > 0 ? double(nbrIndexedBytes) * 1000.0 / double(ns) : 0.0;
+}
+
+}
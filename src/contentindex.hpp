@@ -0,0 +1,221 @@
+#pragma once
+//
+// Copyright (c) Milivoj (Mike) DAVIDOV
+//
+// THIS SOFTWARE IS PROVIDED "AS IS" WITHOUT WARRANTY OF ANY KIND,
+// EITHER EXPRESSED OR IMPLIED, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+// WARRANTIES OF MERCHANTABILITY AND/OR FITNESS FOR A PARTICULAR PURPOSE.
+//
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <shared_mutex>
+#include <unordered_map>
+#include <vector>
+#include <QString>
+
+namespace mmd
+{
+/// @brief Identity of a file's contents, as far as the file system tells:
+/// device, inode (0 on Windows), size and modification time.
+struct FileKey
+{
+    quint64 device{ 0 };
+    quint64 inode{ 0 };
+    qint64 size{ -1 };
+    qint64 mtime{ -1 };  // msec since epoch
+
+    /// Of the file at @p path (not valid if it cannot be stat'ed)
+    static FileKey of(const QString& path);
+    bool isValid() const { return size >= 0; }
+    bool operator==(const FileKey& other) const = default;
+};
+
+/// @brief The distinct trigrams (3 byte sequences, ASCII lower case) of
+/// one file's contents, collected window by window as the file is read.
+/// A trigram seen before is told by a bit set of all 2^24 trigrams, one per
+/// thread (2 MB), so only one TrigramSet may be filled at a time per thread.
+/// @author Milivoj (Mike) DAVIDOV
+///
+class TrigramSet
+{
+public:
+    TrigramSet() = default;
+    ~TrigramSet();
+    TrigramSet(const TrigramSet&) = delete;
+    TrigramSet& operator=(const TrigramSet&) = delete;
+
+    /// The next @p len bytes of the file (a trigram may span two windows)
+    void add(const char* data, std::size_t len);
+    /// The file was sniffed as binary and not read further
+    void setBinary() { binary = true; }
+    bool isBinary() const { return binary; }
+    /// The file was read to its end
+    void setComplete() { complete = true; }
+    bool isComplete() const { return complete; }
+
+    std::size_t size() const { return trigrams.size(); }
+    quint64 nbrBytes() const { return bytes; }
+    quint64 nanoseconds() const { return ns; }
+    /// The trigrams, sorted; the set is empty afterwards
+    std::vector<quint32> takeSorted();
+
+private:
+    void clearSeen();
+
+    std::vector<quint32> trigrams;  // in the order first seen
+    quint32 window{ 0 };            // the last (up to) 3 bytes
+    int nbrInWindow{ 0 };
+    quint64 bytes{ 0 };
+    quint64 ns{ 0 };                // thread time spent in add()
+    bool binary{ false };
+    bool complete{ false };
+};
+
+/// @brief Persistent trigram index of file contents, for repeated word
+/// searches of the same (big) folder structure: for each trigram a posting
+/// list of the files that contain it, and for each file its FileKey.
+/// A search first intersects the posting lists of the trigrams its words
+/// must contain (prepare()): a file that is unchanged since it was indexed
+/// and is not in the intersection cannot match and is not read at all;
+/// the other (candidate) files are verified by the real matchers.
+/// Files not indexed yet, or changed since, are read to their end once and
+/// indexed (store()) by the content reader threads, so the index is built
+/// in parallel, as a side effect of searches.
+/// Trigrams are ASCII case-insensitive, so one index serves all searches
+/// (case-sensitive and whole word matches are left to the matchers).
+/// The files are stored in a binary file next to the scan index (see
+/// ScanIndex), loaded in memory. The posting lists stay on disk, in segment
+/// files next to it that are memory mapped: a search reads only the lists
+/// of its trigrams, the shortest first. The lists of the files indexed since
+/// are kept in memory up to MAX_MEMORY_POSTINGS, then written to a new
+/// segment; save() merges the segments when there are too many of them, or
+/// too many postings of files indexed again. The posting lists are in the
+/// native byte order.
+/// All members are thread-safe.
+/// @author Milivoj (Mike) DAVIDOV
+///
+class ContentIndex
+{
+public:
+    /// What the index tells about a file, without reading it
+    enum class Answer {
+        Unknown,    // not indexed, or changed since: read it (and store())
+        NoMatch,    // does not have the trigrams of the query
+        Candidate,  // may match: read it
+        Binary,     // a binary file, which is not searched
+    };
+
+    /// The trigrams that a matching file must contain: all those of (at least)
+    /// one group; no groups means any file may match.
+    struct Query
+    {
+        std::vector<std::vector<quint32>> groups;  // each one sorted
+    };
+
+    static constexpr std::size_t MAX_MEMORY_POSTINGS = 64 * 1024 * 1024;  // file ids: 256 MB
+    static constexpr std::size_t MAX_SEGMENTS = 8;
+
+    explicit ContentIndex(const QString& filePath);
+    ~ContentIndex();
+
+    /// Returns the index file in the app settings location.
+    static QString defaultFilePath();
+    const QString& fileName() const { return filePath; }
+
+    /// The distinct trigrams of @p utf8 (ASCII lower case), sorted; none if shorter than 3 bytes
+    static std::vector<quint32> trigramsOf(const char* utf8, std::size_t len);
+
+    /// @brief Loads the index file and maps its segments once (later calls do nothing).
+    /// A missing, corrupt or old-version file gives an empty index.
+    void load();
+    /// Writes the index file (and the postings in memory to a segment) if
+    /// anything changed since load() or the previous save().
+    bool save();
+    void clear();
+
+    /// @brief Sets up the search of @p query: intersects its posting lists into
+    /// the candidate files, and resets the statistics.
+    /// Files indexed with other @p decompress / @p inclBinaryFiles settings, or
+    /// decompressed up to less than @p maxDecompressedSize (0: the default), are Unknown.
+    void prepare(const Query& query, bool decompress, quint64 maxDecompressedSize, bool inclBinaryFiles);
+    Answer check(const QString& path, const FileKey& key) const;
+    /// Indexes the contents of @p path read into @p trigrams, if they are
+    /// complete (or the file is binary); @p key is from before it was read.
+    void store(const QString& path, const FileKey& key, TrigramSet& trigrams);
+
+    /// Files not read thanks to the index, and files (bytes) indexed, since prepare()
+    quint64 skippedFiles() const { return nbrSkipped; }
+    quint64 indexedFiles() const { return nbrIndexed; }
+    quint64 indexedBytes() const { return nbrIndexedBytes; }
+    /// Indexed MB per second of one thread (core)
+    double buildMbPerSecond() const;
+    /// Time prepare() took to intersect the posting lists
+    double queryMilliseconds() const { return double(queryNs) / 1e6; }
+
+private:
+    enum Flag : quint8 {
+        Binary = 1,        // sniffed as binary, no trigrams
+        Decompressed = 2,  // indexed with ScanParams::decompress
+    };
+    struct FileRecord {
+        FileKey key;
+        qint64 indexedAt{ -1 };  // msec since epoch
+        quint32 id{ 0 };         // in the posting lists
+        quint8 flags{ 0 };
+        quint64 maxDecompressed{ 0 };  // ScanParams::maxDecompressedSize, if Decompressed
+    };
+    static constexpr std::size_t NBR_SHARDS = 64;
+    /// The posting lists in memory are split by trigram, so that readers seldom wait for each other
+    struct Shard {
+        std::mutex mutex;
+        std::unordered_map<quint32, std::vector<quint32>> lists;  // file ids, sorted when prepared
+    };
+    static std::size_t shardOf(quint32 trigram) { return (trigram * 0x9E3779B1u) >> 26; }
+    class Segment;
+
+    QString segmentPath(quint32 number) const;
+    /// With all the locks held: the lists in memory to a new segment, then
+    /// all the segments to one, without the postings of the files indexed again
+    bool writeMemoryPostings();
+    bool mergeSegments();
+    void removeUnusedSegments();
+    void flushMemoryPostings();
+    /// Of the lists of @p trigram (all the segments and memory): their total size,
+    /// all their ids, or those that are also in @p ids (sorted)
+    std::size_t listSize(quint32 trigram);
+    std::vector<quint32> listOf(quint32 trigram);
+    void intersect(std::vector<quint32>& ids, quint32 trigram);
+
+    const QString filePath;
+    mutable std::shared_mutex mutex;  // of files, nextId, segments, the search state
+    std::map<QString, FileRecord> files;
+    quint32 nextId{ 0 };
+    std::vector<std::unique_ptr<Segment>> segments;  // oldest first
+    quint32 nextSegment{ 0 };
+    std::array<Shard, NBR_SHARDS> shards;
+    std::atomic<std::size_t> nbrMemoryPostings{ 0 };
+    std::atomic<bool> dirty{ false };
+    bool loaded{ false };
+    std::mutex fileMutex;  // of the files written
+
+    // The search set by prepare()
+    std::vector<quint32> candidates;  // sorted file ids
+    bool constrained{ false };
+    bool decompressMode{ false };
+    quint64 maxDecompressed{ 0 };
+    bool binaryFilesSearched{ false };
+
+    mutable std::atomic<quint64> nbrSkipped{ 0 };
+    std::atomic<quint64> nbrIndexed{ 0 };
+    std::atomic<quint64> nbrIndexedBytes{ 0 };
+    std::atomic<quint64> buildNs{ 0 };
+    quint64 queryNs{ 0 };
+};
+
+}
@@ -0,0 +1,300 @@
+//
+// Copyright (c) Milivoj (Mike) DAVIDOV
+//
+// THIS SOFTWARE IS PROVIDED "AS IS" WITHOUT WARRANTY OF ANY KIND,
+// EITHER EXPRESSED OR IMPLIED, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+// WARRANTIES OF MERCHANTABILITY AND/OR FITNESS FOR A PARTICULAR PURPOSE.
+//
+
+#include "contentmatcher.hpp"
+#include <algorithm>
+#include <bit>
+#include <string>
+#include <QByteArray>
+
+namespace mmd
+{
+namespace
+{
+char toLowerAscii(char c)
+{
+    return (c >= 'A' && c <= 'Z') ? char(c - 'A' + 'a') : c;
+}
+
+/// ASCII letters, digits and '_' (as \w), and the bytes of non-ASCII characters
+bool isWordByte(char c)
+{
+    const auto b = static_cast<unsigned char>(c);
+    return b >= 0x80 || (b >= '0' && b <= '9') || (b >= 'a' && b <= 'z') || (b >= 'A' && b <= 'Z') || b == '_';
+}
+
+bool isWordChar(QChar c)
+{
+    return c.unicode() >= 0x80 || isWordByte(char(c.unicode()));
+}
+
+/// True if the byte at @p before (relative to @p data, negative: in @p tail,
+/// the end of the previous blocks) is not a word character, or is before the file
+bool boundaryBefore(const char* tail, std::size_t tailSize, const char* data, std::ptrdiff_t before)
+{
+    if (before >= 0)
+        return !isWordByte(data[before]);
+    const auto t = std::ptrdiff_t(tailSize) + before;
+    return t < 0 || !isWordByte(tail[t]);
+}
+}
+
+ContentMatcher::ContentMatcher(const QStringList& searchWords, bool caseSensitive, const QStringList& exclusionWords,
+                               bool whole)
+    : nbrWords(size_t(searchWords.size() + exclusionWords.size()))
+    , nbrSearch(size_t(searchWords.size()))
+    , matchCase(caseSensitive)
+    , wholeWords(whole)
+    , wordList(searchWords + exclusionWords)
+{
+    std::vector<std::string> patterns;
+    patterns.reserve(nbrWords);
+    for (const auto& word : wordList) {
+        const auto utf8 = word.toUtf8();
+        for (const auto c : utf8) {
+            if (!matchCase && (c & 0x80))
+                decode = true;
+        }
+        patterns.emplace_back(utf8.constData(), size_t(utf8.size()));
+        wordSizes.push_back(size_t(utf8.size()));
+        maxWordSize = std::max(maxWordSize, size_t(utf8.size()));
+    }
+    exclusionBits.assign((nbrWords + 63) / 64, 0);
+    for (auto i = nbrSearch; i < nbrWords; ++i)
+        exclusionBits[i / 64] |= std::uint64_t(1) << (i % 64);
+    if (nbrWords == 1 && !patterns.front().empty())
+        searcher = SubstringSearcher(patterns.front(), matchCase);
+    else
+        automaton = AhoCorasick<char>(patterns, matchCase ? nullptr : toLowerAscii);
+}
+
+ContentMatcher::Progress ContentMatcher::start() const
+{
+    Progress progress;
+    progress.found.assign((nbrWords + 63) / 64, 0);
+    if (wholeWords) {
+        progress.pending.assign(progress.found.size(), 0);
+        progress.hits.assign(progress.found.size(), 0);
+    }
+    return progress;
+}
+
+ContentMatcher::Progress ContentMatcher::resume(const char* before, std::size_t len) const
+{
+    auto progress = start();
+    if (isEmpty())
+        return progress;
+    if (!searcher.isEmpty()) {
+        // What feedSingle() / feedSingleWhole() keep of the previous blocks
+        const auto keep = std::min(len, wholeWords ? searcher.size() : searcher.size() - 1);
+        progress.tail.assign(before + len - keep, keep);
+        return progress;
+    }
+    // The state depends only on the last maxWordSize - 1 bytes
+    const auto from = len > maxWordSize ? len - maxWordSize : 0;
+    for (auto i = from; i < len; ++i)
+        progress.state = automaton.step(progress.state, before[i]);
+    if (wholeWords)
+        keepTail(progress, before, len, maxWordSize);
+    return progress;
+}
+
+bool ContentMatcher::merge(Progress& into, const Progress& from) const
+{
+    return addFound(into, from.found.data());
+}
+
+bool ContentMatcher::addFound(Progress& progress, const std::uint64_t* bits) const
+{
+    auto nbrFound = std::size_t(0);
+    for (std::size_t w = 0; w < progress.found.size(); ++w) {
+        progress.found[w] |= bits[w];
+        if (progress.found[w] & exclusionBits[w])
+            progress.excluded = true;
+        nbrFound += size_t(std::popcount(progress.found[w] & ~exclusionBits[w]));
+    }
+    progress.nbrFound = nbrFound;
+    return isDecided(progress);
+}
+
+void ContentMatcher::keepTail(Progress& progress, const char* data, std::size_t len, std::size_t keep) const
+{
+    auto& tail = progress.tail;
+    if (len >= keep) {
+        tail.assign(data + len - keep, keep);
+        return;
+    }
+    tail.append(data, len);
+    if (tail.size() > keep)
+        tail.erase(0, tail.size() - keep);
+}
+
+bool ContentMatcher::feedPending(Progress& progress, const char* data, std::size_t len) const
+{
+    // Whole words that ended the previous block, if this one starts with a non-word character
+    auto& pending = progress.pending;
+    if (len == 0 || std::all_of(pending.cbegin(), pending.cend(), [](std::uint64_t bits) { return bits == 0; }))
+        return false;
+    const auto decided = !isWordByte(data[0]) && addFound(progress, pending.data());
+    std::fill(pending.begin(), pending.end(), 0);
+    return decided;
+}
+
+void ContentMatcher::finish(Progress& progress) const
+{
+    if (!wholeWords || isEmpty())
+        return;
+    addFound(progress, progress.pending.data());
+    std::fill(progress.pending.begin(), progress.pending.end(), 0);
+}
+
+bool ContentMatcher::containsWord(const QString& text, std::size_t i, bool startsFile, bool endsFile) const
+{
+    const auto& word = wordList[qsizetype(i)];
+    const auto cs = matchCase ? Qt::CaseSensitive : Qt::CaseInsensitive;
+    if (!wholeWords)
+        return text.contains(word, cs);
+    const auto n = word.size();
+    for (auto at = text.indexOf(word, 0, cs); at >= 0; at = text.indexOf(word, at + 1, cs)) {
+        const auto wholeBefore = at > 0 ? !isWordChar(text[at - 1]) : startsFile;
+        const auto wholeAfter = at + n < text.size() ? !isWordChar(text[at + n]) : endsFile;
+        if (wholeBefore && wholeAfter)
+            return true;
+    }
+    return false;
+}
+
+bool ContentMatcher::isDecided(const Progress& progress) const
+{
+    return progress.excluded || (progress.nbrFound == nbrSearch && nbrWords == nbrSearch);
+}
+
+bool ContentMatcher::feed(Progress& progress, const char* data, std::size_t len) const
+{
+    if (isEmpty())
+        return true;
+    if (wholeWords && feedPending(progress, data, len))
+        return true;
+    if (!searcher.isEmpty())
+        return wholeWords ? feedSingleWhole(progress, data, len) : feedSingle(progress, data, len);
+    auto state = progress.state;
+    for (std::size_t i = 0; i < len; ++i) {
+        state = automaton.step(state, data[i]);
+        if (!automaton.isMatch(state))
+            continue;
+        // A word ends here: add it (and the words it ends with) to the found set
+        const auto* outputs = automaton.outputs(state);
+        if (wholeWords) {
+            // Only the words with non-word characters around them
+            auto any = false;
+            for (std::size_t w = 0; w < progress.found.size(); ++w) {
+                progress.hits[w] = 0;
+                for (auto bits = outputs[w] & ~progress.found[w]; bits != 0; bits &= bits - 1) {
+                    const auto bit = bits & (~bits + 1);
+                    const auto size = wordSizes[w * 64 + size_t(std::countr_zero(bits))];
+                    const auto before = std::ptrdiff_t(i + 1) - std::ptrdiff_t(size) - 1;
+                    if (!boundaryBefore(progress.tail.data(), progress.tail.size(), data, before))
+                        continue;
+                    if (i + 1 == len)
+                        progress.pending[w] |= bit;
+                    else if (!isWordByte(data[i + 1]))
+                        progress.hits[w] |= bit;
+                }
+                any = any || progress.hits[w] != 0;
+            }
+            if (!any)
+                continue;
+            outputs = progress.hits.data();
+        }
+        if (addFound(progress, outputs)) {
+            progress.state = state;
+            return true;
+        }
+    }
+    progress.state = state;
+    if (wholeWords)
+        keepTail(progress, data, len, maxWordSize);
+    return false;
+}
+
+bool ContentMatcher::feedSingleWhole(Progress& progress, const char* data, std::size_t len) const
+{
+    const auto n = searcher.size();
+    auto& tail = progress.tail;  // the last n bytes of the previous blocks
+    const auto tailSize = tail.size();
+    const std::uint64_t one = 1;
+    // The hit ending at data[end - 1] (it may start in tail)
+    const auto isWhole = [&](std::size_t end) {
+        const auto before = std::ptrdiff_t(end) - std::ptrdiff_t(n) - 1;
+        if (!boundaryBefore(tail.data(), tailSize, data, before))
+            return false;
+        if (end < len)
+            return !isWordByte(data[end]);
+        progress.pending[0] = 1;
+        return false;
+    };
+    // Hits split between the previous block and this one
+    auto found = false;
+    if (tailSize > 0) {
+        tail.append(data, std::min(len, n - 1));
+        for (std::size_t from = 0; !found && from < tail.size();) {
+            const auto at = searcher.find(tail.data() + from, tail.size() - from);
+            if (at == SubstringSearcher::npos)
+                break;
+            const auto start = from + at;
+            found = start + n > tailSize && isWhole(start + n - tailSize);
+            from = start + 1;
+        }
+        tail.resize(tailSize);
+    }
+    for (std::size_t from = 0; !found && from < len;) {
+        const auto at = searcher.find(data + from, len - from);
+        if (at == SubstringSearcher::npos)
+            break;
+        found = isWhole(from + at + n);
+        from += at + 1;
+    }
+    if (found)
+        return addFound(progress, &one);
+    keepTail(progress, data, len, n);
+    return false;
+}
+
+bool ContentMatcher::feedSingle(Progress& progress, const char* data, std::size_t len) const
+{
+    const auto keep = searcher.size() - 1;
+    auto& tail = progress.tail;
+    // A match split between the previous block and this one
+    auto found = false;
+    if (!tail.empty()) {
+        tail.append(data, std::min(len, keep));
+        found = searcher.find(tail.data(), tail.size()) != SubstringSearcher::npos;
+    }
+    if (!found)
+        found = searcher.find(data, len) != SubstringSearcher::npos;
+    if (found) {
+        progress.found[0] = 1;
+        if (isExclusionWord(0))
+            progress.excluded = true;
+        else
+            progress.nbrFound = 1;
+        return true;
+    }
+    if (len >= keep) {
+        tail.assign(data + len - keep, keep);
+    }
+    else {
+        if (tail.empty())
+            tail.assign(data, len);
+        if (tail.size() > keep)
+            tail.erase(0, tail.size() - keep);
+    }
+    return false;
+}
+
+}
@@ -0,0 +1,118 @@
+#pragma once
+//
+// Copyright (c) Milivoj (Mike) DAVIDOV
+//
+// THIS SOFTWARE IS PROVIDED "AS IS" WITHOUT WARRANTY OF ANY KIND,
+// EITHER EXPRESSED OR IMPLIED, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+// WARRANTIES OF MERCHANTABILITY AND/OR FITNESS FOR A PARTICULAR PURPOSE.
+//
+
+#include "ahocorasick.hpp"
+#include "substringsearcher.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <QStringList>
+
+namespace mmd
+{
+/// @brief Tells if file contents (UTF-8 bytes) have all the search words
+/// and none of the exclusion words, in a single pass: all the words
+/// are compiled into one Aho-Corasick automaton, each byte is read once,
+/// and a bit set records the words found so far.
+/// The automaton state is carried from one block of a file to the next
+/// (see Progress), so blocks need no overlap and a word may span two blocks.
+/// A single word (the usual search) is found with the SIMD SubstringSearcher
+/// instead, the end of each block being kept to find a word split between two.
+/// Case-insensitive matching of bytes is ASCII only: words with non-ASCII
+/// characters need Unicode case folding, see needsDecoding().
+/// Whole words: each hit is kept only if the characters around it are not
+/// word characters (ASCII letters, digits, '_' and all non-ASCII characters),
+/// checked on the bytes at hand when the hit is found; a hit at the end of
+/// a block waits for the first byte of the next one (or finish()).
+/// Compiled once per scan; const, so it can be shared by several threads.
+/// @author Milivoj (Mike) DAVIDOV
+///
+class ContentMatcher
+{
+public:
+    ContentMatcher() = default;
+    ContentMatcher(const QStringList& searchWords, bool matchCase, const QStringList& exclusionWords = {},
+                   bool wholeWords = false);
+
+    bool isEmpty() const { return nbrWords == 0; }
+    std::size_t size() const { return nbrWords; }
+
+    /// True if the words cannot be matched on bytes (caseless non-ASCII words)
+    bool needsDecoding() const { return decode; }
+    /// The search words, then the exclusion words
+    const QStringList& words() const { return wordList; }
+    std::size_t nbrSearchWords() const { return nbrSearch; }
+    bool isExclusionWord(std::size_t i) const { return i >= nbrSearch; }
+    bool matchesCase() const { return matchCase; }
+    bool matchesWholeWords() const { return wholeWords; }
+    /// Bytes (UTF-8) of the longest word
+    std::size_t maxWordLength() const { return maxWordSize; }
+
+    /// @brief Tells if decoded @p text contains words()[@p i] (as a whole word
+    /// if matchesWholeWords()). Unless @p startsFile / @p endsFile, a hit
+    /// at the start / end of @p text is not a whole word: its neighbour is unknown.
+    bool containsWord(const QString& text, std::size_t i, bool startsFile, bool endsFile) const;
+
+    /// Matching state of one file
+    struct Progress
+    {
+        AhoCorasick<char>::State state{ AhoCorasick<char>::start() };
+        std::vector<std::uint64_t> found;  // bit i: words()[i]
+        std::size_t nbrFound{ 0 };  // search words
+        bool excluded{ false };  // an exclusion word was found
+        std::string tail;  // end of the previous block (single word, or whole words)
+        std::vector<std::uint64_t> pending;  // whole words ending with the previous block
+        std::vector<std::uint64_t> hits;  // whole words: scratch
+    };
+    Progress start() const;
+    /// @brief Matching state of a part of a file that starts after @p before
+    /// (at least maxWordLength() bytes, unless the file starts there),
+    /// as if they had been fed but without the words in them: a word may
+    /// start in @p before, and a whole word is checked on the byte before it.
+    Progress resume(const char* before, std::size_t len) const;
+
+    /// @brief Feeds the next @p len bytes of the file.
+    /// Returns early (true) when the result is known: an exclusion word
+    /// was found, or all the search words were and there are no exclusion words.
+    bool feed(Progress& progress, const char* data, std::size_t len) const;
+
+    /// At the end of the file: whole words that end it are found
+    void finish(Progress& progress) const;
+
+    /// @brief Adds the words found in @p from (e.g. another part of the file) to @p into.
+    /// Returns true when the result is known, as feed().
+    bool merge(Progress& into, const Progress& from) const;
+
+    /// The result, once the whole file (or only its start, if feed() returned true) is fed
+    /// and finished
+    bool matches(const Progress& progress) const { return !progress.excluded && progress.nbrFound == nbrSearch; }
+
+private:
+    bool feedSingle(Progress& progress, const char* data, std::size_t len) const;
+    bool feedSingleWhole(Progress& progress, const char* data, std::size_t len) const;
+    bool feedPending(Progress& progress, const char* data, std::size_t len) const;
+    bool addFound(Progress& progress, const std::uint64_t* bits) const;
+    void keepTail(Progress& progress, const char* data, std::size_t len, std::size_t keep) const;
+    bool isDecided(const Progress& progress) const;
+
+    AhoCorasick<char> automaton;
+    SubstringSearcher searcher;  // if a single word
+    std::vector<std::uint64_t> exclusionBits;  // bit i: words()[i] is an exclusion word
+    std::vector<std::size_t> wordSizes;  // bytes
+    std::size_t maxWordSize{ 0 };
+    std::size_t nbrWords{ 0 };
+    std::size_t nbrSearch{ 0 };
+    bool decode{ false };
+    bool matchCase{ true };
+    bool wholeWords{ false };
+    QStringList wordList;
+};
+
+}
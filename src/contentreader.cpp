@@ -0,0 +1,389 @@
+//
+// Copyright (c) Milivoj (Mike) DAVIDOV
+//
+// THIS SOFTWARE IS PROVIDED "AS IS" WITHOUT WARRANTY OF ANY KIND,
+// EITHER EXPRESSED OR IMPLIED, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+// WARRANTIES OF MERCHANTABILITY AND/OR FITNESS FOR A PARTICULAR PURPOSE.
+//
+
+#include "contentreader.hpp"
+#include <algorithm>
+#include <chrono>
+#if defined(Q_OS_LINUX)
+#include <cerrno>
+#include <cstdint>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#elif defined(Q_OS_UNIX)
+#include <unistd.h>
+#endif
+
+namespace mmd
+{
+namespace
+{
+#if defined(Q_OS_LINUX)
+// O_DIRECT transfers: buffer address, file offset and length multiple of the
+// logical block size, which is at most the page size in practice
+constexpr qint64 DIRECT_ALIGN = 4096;
+
+qint64 pageSize()
+{
+    static const auto size = qint64(sysconf(_SC_PAGESIZE));
+    return size;
+}
+#endif
+}
+
+ContentReader::ContentReader(const QString& filePath, MemoryBudget* memoryBudget)
+    : file(filePath)
+    , budget(memoryBudget)
+{
+    if (file.open(QIODevice::ReadOnly)) {
+        fileSize = file.size();
+#if defined(Q_OS_LINUX)
+        // Twice the readahead, and the pages behind are reclaimed first
+        posix_fadvise(file.handle(), 0, 0, POSIX_FADV_SEQUENTIAL);
+#endif
+    }
+    end = fileSize;
+}
+
+ContentReader::~ContentReader()
+{
+    unmap();
+    // Also the pages read ahead of an early end
+    dropReadPages(end);
+    if (holeBytes && nbrHoleBytes > 0)
+        *holeBytes += quint64(nbrHoleBytes);
+#if defined(Q_OS_LINUX)
+    if (directFd >= 0)
+        ::close(directFd);
+#endif
+    if (decompressor && stats) {
+        if (decompressor->overMemLimit())
+            ++stats->nbrOverLimit;
+        else
+            ++stats->nbrFiles;
+        stats->nbrBytes += nbrDecompressed;
+    }
+}
+
+void ContentReader::setDecompression(quint64 maxSize, DecompressionStats* decompressionStats)
+{
+    decompress = true;
+    maxDecompressed = maxSize > 0 ? maxSize : Decompressor::DEFAULT_MAX_SIZE;
+    stats = decompressionStats;
+}
+
+void ContentReader::setRange(qint64 offset, qint64 length, Decompressor::Format dataFormat)
+{
+    begin = std::clamp<qint64>(offset, 0, fileSize);
+    end = std::clamp<qint64>(offset + length, begin, fileSize);
+    pos = begin;
+    format = dataFormat;
+    if (format != Decompressor::Format::None) {
+        decompress = true;
+        if (!Decompressor::isSupported(format))
+            end = begin;
+    }
+}
+
+void ContentReader::setCacheUse(bool spare, qint64 minSize)
+{
+#if defined(Q_OS_LINUX)
+    spareCache = spare;
+    directMinSize = std::max<qint64>(minSize, 0);
+#else
+    (void)spare;
+    (void)minSize;
+#endif
+}
+
+void ContentReader::snapshotResidency()
+{
+#if defined(Q_OS_LINUX)
+    // Mapping the whole range reads nothing; mincore() tells which of its
+    // pages are cached, before the readahead of the first window changes that.
+    if (end <= begin)
+        return;
+    auto* whole = file.map(begin, end - begin);
+    if (!whole)
+        return;
+    const auto page = std::uintptr_t(pageSize());
+    const auto addr = reinterpret_cast<std::uintptr_t>(whole);
+    const auto start = addr & ~(page - 1);
+    const auto total = addr + std::uintptr_t(end - begin) - start;
+    residentPages.resize((total + page - 1) / page);
+    if (mincore(reinterpret_cast<void*>(start), total, residentPages.data()) != 0)
+        residentPages.clear();
+    pagesOffset = begin - begin % qint64(page);
+    file.unmap(whole);
+#endif
+}
+
+void ContentReader::dropReadPages(qint64 upTo)
+{
+#if defined(Q_OS_LINUX)
+    // Not while mapped: the pages of a mapping are not dropped
+    if (residentPages.empty() || mapped)
+        return;
+    const auto page = pageSize();
+    const auto last = std::min(residentPages.size(), std::size_t((upTo - pagesOffset) / page));
+    auto i = nbrDropped;
+    while (i < last) {
+        if (residentPages[i] & 1) {
+            ++i;
+            continue;
+        }
+        auto j = i + 1;
+        while (j < last && !(residentPages[j] & 1))
+            ++j;
+        posix_fadvise(file.handle(), pagesOffset + qint64(i) * page, qint64(j - i) * page, POSIX_FADV_DONTNEED);
+        i = j;
+    }
+    nbrDropped = std::max(nbrDropped, last);
+#else
+    (void)upTo;
+#endif
+}
+
+void ContentReader::releaseMemory()
+{
+    unmap();
+    dropReadPages(end);
+    std::vector<char>().swap(buffer);
+    std::vector<char>().swap(directBuffer);
+    std::vector<char>().swap(outBuffer);
+    lease.reset();
+    pos = end;
+    inputEnd = true;
+    released = true;
+}
+
+void ContentReader::unmap()
+{
+    if (mapped) {
+        file.unmap(mapped);
+        mapped = nullptr;
+    }
+}
+
+bool ContentReader::next(const char*& data, qint64& len)
+{
+    if (decompressor)
+        return nextDecompressed(data, len);
+    const auto first = pos == begin;
+    if (!nextRaw(data, len))
+        return false;
+    if (decompress && first) {
+        if (format == Decompressor::Format::None)
+            format = Decompressor::formatOf(data, size_t(len));
+        if (Decompressor::isSupported(format)) {
+            // The decoder state: up to the read budget, but all the standard presets
+            const auto memLimit = std::max<std::uint64_t>(budget ? budget->limit() : 0, Decompressor::DEFAULT_MEM_LIMIT);
+            decompressor = std::make_unique<Decompressor>(format, memLimit);
+            input = data;
+            inputLen = size_t(len);
+            return nextDecompressed(data, len);
+        }
+    }
+    return true;
+}
+
+bool ContentReader::nextDecompressed(const char*& data, qint64& len)
+{
+    if (nbrDecompressed >= maxDecompressed && !released)
+        ended = true;
+    if (inputEnd || nbrDecompressed >= maxDecompressed)
+        return false;
+    if (outBuffer.empty()) {
+        if (budget) {
+            // Released and leased again for both buffers: waiting for a second
+            // lease while holding the first could deadlock all the readers
+            const auto bytes = lease.bytes() + size_t(WINDOW_SIZE);
+            lease.reset();
+            lease = budget->lease(bytes, cancel);
+            if (lease.bytes() == 0)
+                return false;
+        }
+        outBuffer.resize(size_t(WINDOW_SIZE));
+    }
+    char* out = outBuffer.data();
+    auto outLeft = size_t(std::min<quint64>(quint64(WINDOW_SIZE), maxDecompressed - nbrDecompressed));
+    const auto outSize = outLeft;
+    const auto start = std::chrono::steady_clock::now();
+    while (outLeft > 0) {
+        if (inputLen == 0) {
+            qint64 rawLen = 0;
+            if (!nextRaw(input, rawLen)) {
+                // The decoder may still hold output: the end when it has none left
+                if (!decompressor->flush(out, outLeft) || outLeft > 0)
+                    inputEnd = true;
+                break;
+            }
+            inputLen = size_t(rawLen);
+        }
+        // Corrupt data: search what was decompressed before it
+        if (!decompressor->decompress(input, inputLen, out, outLeft)) {
+            inputEnd = true;
+            // Not for good if only the memory limit was too low
+            ended = !decompressor->overMemLimit();
+            break;
+        }
+    }
+    if (stats) {
+        stats->nanoseconds += quint64(std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now() - start).count());
+    }
+    const auto produced = outSize - outLeft;
+    if (produced == 0)
+        return false;
+    nbrDecompressed += produced;
+    data = outBuffer.data();
+    len = qint64(produced);
+    return true;
+}
+
+bool ContentReader::nextRaw(const char*& data, qint64& len)
+{
+    if (!file.isOpen() || released)
+        return false;
+    if (pos >= end) {
+        ended = true;
+        return false;
+    }
+    if (budget && lease.bytes() == 0) {
+        // Leased once, for the biggest window of this file
+        lease = budget->lease(size_t(std::min(WINDOW_SIZE, end - begin)), cancel);
+        if (lease.bytes() == 0)
+            return false;  // cancelled
+    }
+#if defined(Q_OS_LINUX)
+    if (pos == begin && directFd < 0 && directMinSize > 0 && fileSize >= directMinSize)
+        directFd = ::open(QFile::encodeName(file.fileName()).constData(), O_RDONLY | O_DIRECT | O_CLOEXEC);
+    if (pos == begin && spareCache && residentPages.empty())
+        snapshotResidency();
+#endif
+    // The decompressor (set by the first window) needs all the bytes
+    if (pos > begin && !decompressor && skipHole(data, len))
+        return true;
+#if defined(Q_OS_LINUX)
+    if (directFd >= 0)
+        return nextDirect(data, len);
+#endif
+    if (mapping) {
+        unmap();
+        dropReadPages(pos);
+        const auto mapLen = std::min(WINDOW_SIZE, dataEnd() - pos);
+        mapped = file.map(pos, mapLen);
+        if (mapped) {
+            data = reinterpret_cast<const char*>(mapped);
+            len = mapLen;
+            pos += mapLen;
+            return true;
+        }
+        // Read the rest through the buffer
+        mapping = false;
+        if (!file.seek(pos))
+            return false;
+    }
+    return nextBuffered(data, len);
+}
+
+bool ContentReader::nextDirect(const char*& data, qint64& len)
+{
+#if defined(Q_OS_LINUX)
+    // The data is read to an aligned address
+    if (directBuffer.empty())
+        directBuffer.resize(size_t(DIRECT_ALIGN + WINDOW_SIZE));
+    const auto addr = reinterpret_cast<std::uintptr_t>(directBuffer.data());
+    const auto aligned = (addr + std::uintptr_t(DIRECT_ALIGN - 1)) & ~std::uintptr_t(DIRECT_ALIGN - 1);
+    char* const dataStart = directBuffer.data() + (aligned - addr);
+    // A range (e.g. a segment) may start anywhere: from the aligned offset
+    // before it, skipping the lead bytes; then pos stays aligned
+    const auto lead = pos % DIRECT_ALIGN;
+    const auto from = pos - lead;
+    // Up to the next hole, rounded up to the alignment (its first bytes are zeros)
+    const auto want = std::min(WINDOW_SIZE, (dataEnd() - from + DIRECT_ALIGN - 1) / DIRECT_ALIGN * DIRECT_ALIGN);
+    const auto nread = ::pread(directFd, dataStart, size_t(want), from);
+    if (nread < 0 && errno == EINVAL && pos == begin) {
+        // Not supported by this file system after all
+        ::close(directFd);
+        directFd = -1;
+        directMinSize = 0;
+        return nextRaw(data, len);
+    }
+    if (nread <= lead)
+        return false;
+    len = std::min(qint64(nread) - lead, end - pos);
+    pos += len;
+    data = dataStart + lead;
+    return true;
+#else
+    (void)data;
+    (void)len;
+    return false;
+#endif
+}
+
+bool ContentReader::skipHole(const char*& data, qint64& len)
+{
+#if defined(SEEK_HOLE) && defined(SEEK_DATA)
+    // The queries move the file offset, which QFile reads from (not mapped)
+    const auto fd = file.handle();
+    const auto offset = ::lseek(fd, 0, SEEK_CUR);
+    const auto query = [fd, offset](qint64 from, int whence) {
+        const auto at = ::lseek(fd, from, whence);
+        ::lseek(fd, offset, SEEK_SET);
+        return qint64(at);
+    };
+    // The end of the file is a hole too: no holes if that is the first one
+    if (holeAt < pos) {
+        holeAt = query(pos, SEEK_HOLE);
+        if (holeAt < 0)
+            holeAt = end;  // not supported
+    }
+    if (pos < holeAt || pos >= end)
+        return false;
+    auto dataAt = query(pos, SEEK_DATA);
+    dataAt = dataAt < 0 ? end : std::min(dataAt, end);  // ENXIO: a hole up to the end
+#if defined(Q_OS_LINUX)
+    if (directFd >= 0)
+        dataAt -= dataAt % DIRECT_ALIGN;
+#endif
+    if (dataAt <= pos) {
+        holeAt = -1;  // e.g. a hole smaller than the O_DIRECT alignment: read as zeros
+        return false;
+    }
+    nbrHoleBytes += dataAt - pos;
+    pos = dataAt;
+    holeAt = -1;
+    if (!mapping && !file.seek(pos))
+        return false;
+    static const char zero = 0;
+    data = &zero;
+    len = 1;
+    return true;
+#else
+    (void)data;
+    (void)len;
+    return false;
+#endif
+}
+
+bool ContentReader::nextBuffered(const char*& data, qint64& len)
+{
+    if (buffer.empty())
+        buffer.resize(size_t(std::min(WINDOW_SIZE, end - begin)));
+    const auto nread = file.read(buffer.data(), std::min(qint64(buffer.size()), dataEnd() - pos));
+    if (nread <= 0)
+        return false;
+    pos += nread;
+    data = buffer.data();
+    len = nread;
+    return true;
+}
+
+}
@@ -0,0 +1,144 @@
+#pragma once
+//
+// Copyright (c) Milivoj (Mike) DAVIDOV
+//
+// THIS SOFTWARE IS PROVIDED "AS IS" WITHOUT WARRANTY OF ANY KIND,
+// EITHER EXPRESSED OR IMPLIED, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+// WARRANTIES OF MERCHANTABILITY AND/OR FITNESS FOR A PARTICULAR PURPOSE.
+//
+
+#include "decompressor.hpp"
+#include "memorybudget.hpp"
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <vector>
+#include <QFile>
+#include <QString>
+
+namespace mmd
+{
+/// @brief Reads a file as a sequence of byte windows, without copying
+/// or decoding: each window is memory mapped (QFile::map) and unmapped
+/// when the next one is requested; if the file cannot be mapped
+/// (e.g. some network or virtual file systems), it is read through
+/// a buffer of the same size instead. So the memory used does not depend
+/// on the file size: one window of WINDOW_SIZE bytes at most,
+/// leased from the optional @c budget shared by all the readers (once per
+/// reader, together with the buffer of the decompressed bytes, if any).
+/// The windows do not overlap: a search carries its state from one to the next.
+/// Optionally (setDecompression()) a gzip, zstd or xz file is decompressed
+/// on the fly: the windows are then those of the decompressed bytes, made
+/// one at a time from the (mapped) compressed windows, up to a maximum size.
+/// So a search that ends early (e.g. when a word is found) decompresses
+/// only the start of the file.
+/// The holes of a sparse file (SEEK_HOLE / SEEK_DATA, where supported) are
+/// not read: each one is given as a window of a single zero byte, so no word
+/// spans it. Not in the first window, which the binary sniffing sees as it
+/// is, nor in compressed data.
+/// On Linux the reads are sequential (more readahead), and optionally
+/// (setCacheUse()) they spare the page cache: the pages read that were not
+/// cached before are dropped once read, and big files can be read with
+/// O_DIRECT, around the cache.
+/// @author Milivoj (Mike) DAVIDOV
+///
+class ContentReader
+{
+public:
+    static constexpr qint64 WINDOW_SIZE = 1024 * 1024;
+
+    explicit ContentReader(const QString& filePath, MemoryBudget* budget = nullptr);
+    ~ContentReader();
+    ContentReader(const ContentReader&) = delete;
+    ContentReader& operator=(const ContentReader&) = delete;
+
+    bool isOpen() const { return file.isOpen(); }
+    qint64 size() const { return fileSize; }
+
+    /// @brief Decompresses the file if it is compressed in a supported format,
+    /// up to @p maxSize bytes (0: Decompressor::DEFAULT_MAX_SIZE).
+    /// Before the first next(); the work done is added to the optional @p stats.
+    /// A file whose decoder needs more memory than the budget (at least
+    /// Decompressor::DEFAULT_MEM_LIMIT) gives no bytes: it is not searchable.
+    void setDecompression(quint64 maxSize, DecompressionStats* stats = nullptr);
+    bool isDecompressing() const { return decompressor != nullptr; }
+
+    /// @brief Reads only the @p length bytes at @p offset (e.g. an archive member),
+    /// decompressed as @p format unless Format::None (nothing is read if it is
+    /// not supported). Before the first next().
+    void setRange(qint64 offset, qint64 length, Decompressor::Format format = Decompressor::Format::None);
+
+    /// @brief Drops the pages read (mapped) that were not cached before, if @p spare;
+    /// reads a file of at least @p directMinSize bytes (0: none), or a range of it, with O_DIRECT,
+    /// if the file system supports it. Linux only (elsewhere it does nothing).
+    /// Before the first next().
+    void setCacheUse(bool spare, qint64 directMinSize = 0);
+
+    /// Stops waiting for the memory budget (and reading) when @p flag is set.
+    void setCancel(const std::atomic<bool>* flag) { cancel = flag; }
+
+    /// The bytes of the holes skipped are added to @p bytes (e.g. shared by all the readers).
+    void countHoles(std::atomic<std::uint64_t>* bytes) { holeBytes = bytes; }
+
+    /// @brief Gets the next window of the file.
+    /// @return false at the end of the file, or if it could not be read.
+    bool next(const char*& data, qint64& len);
+    /// next() returned false at the end of the file (or of the maximum size
+    /// decompressed): not if it could not be read, or was cancelled or released.
+    bool atEnd() const { return ended; }
+
+    /// Gives the window memory (and its budget lease) back before the reader
+    /// is destroyed, e.g. before other readers lease theirs; next() then returns false.
+    void releaseMemory();
+
+private:
+    void unmap();
+    bool nextRaw(const char*& data, qint64& len);
+    bool nextBuffered(const char*& data, qint64& len);
+    bool nextDecompressed(const char*& data, qint64& len);
+    bool nextDirect(const char*& data, qint64& len);
+    bool skipHole(const char*& data, qint64& len);
+    qint64 dataEnd() const { return holeAt > pos ? std::min(holeAt, end) : end; }
+    void snapshotResidency();
+    void dropReadPages(qint64 upTo);
+
+    QFile file;
+    qint64 fileSize{ 0 };
+    qint64 begin{ 0 };  // of the bytes to read
+    qint64 end{ 0 };
+    MemoryBudget* budget;
+    MemoryBudget::Lease lease;  // of the window, and of outBuffer
+    const std::atomic<bool>* cancel{ nullptr };
+    qint64 pos{ 0 };  // of the first byte not returned yet
+    uchar* mapped{ nullptr };
+    bool mapping{ true };
+    std::vector<char> buffer;
+    bool ended{ false };
+    bool released{ false };
+
+    qint64 holeAt{ -1 };  // the next hole, -1 if not known yet
+    qint64 nbrHoleBytes{ 0 };
+    std::atomic<std::uint64_t>* holeBytes{ nullptr };
+
+    bool spareCache{ false };
+    std::vector<unsigned char> residentPages;  // mincore() of [begin, end) before the first read
+    qint64 pagesOffset{ 0 };  // of residentPages[0]
+    std::size_t nbrDropped{ 0 };  // residentPages done
+    qint64 directMinSize{ 0 };
+    int directFd{ -1 };
+    std::vector<char> directBuffer;  // over-allocated to align the data to DIRECT_ALIGN
+
+    bool decompress{ false };
+    Decompressor::Format format{ Decompressor::Format::None };  // if known beforehand
+    quint64 maxDecompressed{ Decompressor::DEFAULT_MAX_SIZE };
+    DecompressionStats* stats{ nullptr };
+    std::unique_ptr<Decompressor> decompressor;
+    std::vector<char> outBuffer;
+    quint64 nbrDecompressed{ 0 };
+    const char* input{ nullptr };  // compressed bytes not decompressed yet
+    std::size_t inputLen{ 0 };
+    bool inputEnd{ false };
+};
+
+}
@@ -0,0 +1,85 @@
+//
+// Copyright (c) Milivoj (Mike) DAVIDOV
+//
+// THIS SOFTWARE IS PROVIDED "AS IS" WITHOUT WARRANTY OF ANY KIND,
+// EITHER EXPRESSED OR IMPLIED, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+// WARRANTIES OF MERCHANTABILITY AND/OR FITNESS FOR A PARTICULAR PURPOSE.
+//
+
+#include "contentsniffer.hpp"
+#include <algorithm>
+#include <cstring>
+#include <string_view>
+
+namespace mmd
+{
+namespace
+{
+struct Signature
+{
+    std::size_t offset;
+    std::string_view magic;
+};
+
+using namespace std::string_view_literals;
+
+// Only signatures that text files practically never start with
+constexpr Signature signatures[] = {
+    { 0, "\x7f" "ELF"sv },                  // Linux/BSD executable, .o, .so
+    { 0, "MZ\x90\x00"sv },                  // Windows .exe, .dll
+    { 0, "\xfe\xed\xfa\xce"sv },            // Mach-O
+    { 0, "\xfe\xed\xfa\xcf"sv },
+    { 0, "\xce\xfa\xed\xfe"sv },
+    { 0, "\xcf\xfa\xed\xfe"sv },
+    { 0, "\xca\xfe\xba\xbe"sv },            // Mach-O universal, Java .class
+    { 0, "!<arch>\n"sv },                   // .a, .lib
+    { 0, "\x00" "asm"sv },                  // WebAssembly
+    { 0, "PK\x03\x04"sv },                  // zip, jar, docx, xlsx, odt, apk
+    { 0, "PK\x05\x06"sv },                  // empty zip
+    { 0, "\x1f\x8b"sv },                    // gzip
+    { 0, "\xfd" "7zXZ\x00"sv },             // xz
+    { 0, "\x28\xb5\x2f\xfd"sv },            // zstd
+    { 0, "7z\xbc\xaf\x27\x1c"sv },          // 7z
+    { 0, "Rar!\x1a\x07"sv },                // rar
+    { 0, "\x89PNG\r\n\x1a\n"sv },
+    { 0, "\xff\xd8\xff"sv },                // JPEG
+    { 0, "GIF87a"sv },
+    { 0, "GIF89a"sv },
+    { 0, "II*\x00"sv },                     // TIFF
+    { 0, "MM\x00*"sv },
+    { 0, "RIFF"sv },                        // WAV, AVI, WebP
+    { 0, "OggS"sv },
+    { 0, "fLaC"sv },
+    { 4, "ftyp"sv },                        // MP4, MOV, HEIC
+    { 0, "\x1a\x45\xdf\xa3"sv },            // Matroska, WebM
+    { 0, "%PDF-"sv },
+    { 0, "SQLite format 3\x00"sv },
+    { 0, "\xd0\xcf\x11\xe0\xa1\xb1\x1a\xe1"sv },  // MS Office 97-2003, .msi
+};
+
+bool startsWith(const char* data, std::size_t len, const Signature& sig)
+{
+    return len >= sig.offset + sig.magic.size() &&
+        std::memcmp(data + sig.offset, sig.magic.data(), sig.magic.size()) == 0;
+}
+
+bool hasUnicodeBom(const char* data, std::size_t len)
+{
+    // UTF-16 and UTF-32 text has NUL bytes
+    return len >= 2 &&
+        ((data[0] == '\xff' && data[1] == '\xfe') || (data[0] == '\xfe' && data[1] == '\xff') ||
+         (len >= 4 && std::memcmp(data, "\x00\x00\xfe\xff", 4) == 0));
+}
+}
+
+bool looksBinary(const char* data, std::size_t len)
+{
+    len = std::min(len, SNIFF_SIZE);
+    for (const auto& sig : signatures) {
+        if (startsWith(data, len, sig))
+            return true;
+    }
+    return !hasUnicodeBom(data, len) && std::memchr(data, 0, len) != nullptr;
+}
+
+}
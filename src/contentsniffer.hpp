@@ -0,0 +1,26 @@
+#pragma once
+//
+// Copyright (c) Milivoj (Mike) DAVIDOV
+//
+// THIS SOFTWARE IS PROVIDED "AS IS" WITHOUT WARRANTY OF ANY KIND,
+// EITHER EXPRESSED OR IMPLIED, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+// WARRANTIES OF MERCHANTABILITY AND/OR FITNESS FOR A PARTICULAR PURPOSE.
+//
+
+#include <cstddef>
+
+namespace mmd
+{
+    /// Number of bytes at the start of a file that looksBinary() needs
+    constexpr std::size_t SNIFF_SIZE = 8000;
+
+    /// @brief Tells if the start of a file (up to SNIFF_SIZE bytes of @p data)
+    /// is that of a binary file: an executable, object file or library
+    /// (ELF, PE, Mach-O, Java class, WebAssembly), an archive or compressed
+    /// file (zip and its derivatives, gzip, xz, zstd, 7z, rar), an image,
+    /// audio or video file, a PDF or SQLite database, or any file with
+    /// a NUL byte (unless it starts with a UTF-16/32 byte order mark).
+    /// (A gzip, zstd or xz file that is decompressed, see ContentReader,
+    /// is sniffed by its decompressed contents instead.)
+    bool looksBinary(const char* data, std::size_t len);
+}
@@ -0,0 +1,282 @@
+//
+// Copyright (c) Milivoj (Mike) DAVIDOV
+//
+// THIS SOFTWARE IS PROVIDED "AS IS" WITHOUT WARRANTY OF ANY KIND,
+// EITHER EXPRESSED OR IMPLIED, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+// WARRANTIES OF MERCHANTABILITY AND/OR FITNESS FOR A PARTICULAR PURPOSE.
+//
+
+#include "decompressor.hpp"
+#include <algorithm>
+#include <bit>
+#include <climits>
+#include <cstring>
+
+#if defined(MMD_HAVE_ZLIB)
+#include <zlib.h>
+#endif
+#if defined(MMD_HAVE_ZSTD)
+#include <zstd.h>
+#endif
+#if defined(MMD_HAVE_LZMA)
+#include <lzma.h>
+#endif
+
+namespace mmd
+{
+struct Decompressor::Codec
+{
+    virtual ~Codec() = default;
+    virtual bool decompress(const char*& in, std::size_t& inLen, char*& out, std::size_t& outLeft) = 0;
+    virtual bool flush(char*& out, std::size_t& outLeft) = 0;
+    bool overMemLimit{ false };
+};
+
+namespace
+{
+bool startsWith(const char* data, std::size_t len, const char* magic, std::size_t magicLen)
+{
+    return len >= magicLen && std::memcmp(data, magic, magicLen) == 0;
+}
+
+#if defined(MMD_HAVE_ZLIB)
+class GzipCodec : public Decompressor::Codec
+{
+public:
+    /// @p raw: deflate data without the gzip header and trailer
+    explicit GzipCodec(bool raw) {
+        ok = inflateInit2(&stream, raw ? -MAX_WBITS : 16 + MAX_WBITS) == Z_OK;
+    }
+    ~GzipCodec() override {
+        if (ok)
+            inflateEnd(&stream);
+    }
+    bool decompress(const char*& in, std::size_t& inLen, char*& out, std::size_t& outLeft) override {
+        while (ok && inLen > 0 && outLeft > 0) {
+            // zlib counts in uInt
+            const auto inChunk = uInt(std::min<std::size_t>(inLen, UINT_MAX));
+            const auto outChunk = uInt(std::min<std::size_t>(outLeft, UINT_MAX));
+            stream.next_in = reinterpret_cast<Bytef*>(const_cast<char*>(in));
+            stream.avail_in = inChunk;
+            stream.next_out = reinterpret_cast<Bytef*>(out);
+            stream.avail_out = outChunk;
+            const auto res = inflate(&stream, Z_NO_FLUSH);
+            in += inChunk - stream.avail_in;
+            inLen -= inChunk - stream.avail_in;
+            out += outChunk - stream.avail_out;
+            outLeft -= outChunk - stream.avail_out;
+            if (res == Z_STREAM_END)
+                ok = inflateReset(&stream) == Z_OK;  // the next member, if any
+            else if (res != Z_OK && res != Z_BUF_ERROR)
+                return false;
+        }
+        return ok;
+    }
+    bool flush(char*& out, std::size_t& outLeft) override {
+        // A match copy may have stopped at the end of the output
+        while (ok && outLeft > 0) {
+            const auto outChunk = uInt(std::min<std::size_t>(outLeft, UINT_MAX));
+            stream.next_in = nullptr;
+            stream.avail_in = 0;
+            stream.next_out = reinterpret_cast<Bytef*>(out);
+            stream.avail_out = outChunk;
+            const auto res = inflate(&stream, Z_NO_FLUSH);
+            const auto produced = outChunk - stream.avail_out;
+            out += produced;
+            outLeft -= produced;
+            if (res == Z_STREAM_END) {
+                ok = inflateReset(&stream) == Z_OK;
+                break;
+            }
+            if (res == Z_BUF_ERROR || (res == Z_OK && produced == 0))
+                break;
+            if (res != Z_OK)
+                return false;
+        }
+        return ok;
+    }
+
+private:
+    z_stream stream{};
+    bool ok{ false };
+};
+#endif
+
+#if defined(MMD_HAVE_ZSTD)
+class ZstdCodec : public Decompressor::Codec
+{
+public:
+    explicit ZstdCodec(std::uint64_t memLimit) : stream(ZSTD_createDStream()) {
+        // The window is most of the state: the biggest power of 2 in the limit
+        const auto windowLog = std::clamp(int(std::bit_width(memLimit)) - 1, 10, 31);
+        if (stream)
+            ZSTD_DCtx_setParameter(stream, ZSTD_d_windowLogMax, windowLog);
+    }
+    ~ZstdCodec() override { ZSTD_freeDStream(stream); }
+    bool decompress(const char*& in, std::size_t& inLen, char*& out, std::size_t& outLeft) override {
+        if (!stream)
+            return false;
+        // One frame after another, the state is reset at the end of each
+        ZSTD_inBuffer input{ in, inLen, 0 };
+        ZSTD_outBuffer output{ out, outLeft, 0 };
+        auto res = std::size_t(0);
+        while (input.pos < input.size && output.pos < output.size) {
+            res = ZSTD_decompressStream(stream, &output, &input);
+            if (ZSTD_isError(res))
+                break;
+        }
+        in += input.pos;
+        inLen -= input.pos;
+        out += output.pos;
+        outLeft -= output.pos;
+        if (ZSTD_isError(res) && ZSTD_getErrorCode(res) == ZSTD_error_frameParameter_windowTooLarge)
+            overMemLimit = true;
+        return !ZSTD_isError(res);
+    }
+    bool flush(char*& out, std::size_t& outLeft) override {
+        if (!stream)
+            return false;
+        // Up to a whole decoded block may be held
+        ZSTD_inBuffer input{ nullptr, 0, 0 };
+        ZSTD_outBuffer output{ out, outLeft, 0 };
+        auto res = std::size_t(0);
+        while (output.pos < output.size) {
+            const auto before = output.pos;
+            res = ZSTD_decompressStream(stream, &output, &input);
+            if (ZSTD_isError(res) || res == 0 || output.pos == before)
+                break;
+        }
+        out += output.pos;
+        outLeft -= output.pos;
+        return !ZSTD_isError(res);
+    }
+
+private:
+    ZSTD_DStream* stream;
+};
+#endif
+
+#if defined(MMD_HAVE_LZMA)
+class XzCodec : public Decompressor::Codec
+{
+public:
+    explicit XzCodec(std::uint64_t memLimit) {
+        ok = lzma_stream_decoder(&stream, memLimit, LZMA_CONCATENATED) == LZMA_OK;
+    }
+    ~XzCodec() override { lzma_end(&stream); }
+    bool decompress(const char*& in, std::size_t& inLen, char*& out, std::size_t& outLeft) override {
+        if (!ok)
+            return false;
+        stream.next_in = reinterpret_cast<const std::uint8_t*>(in);
+        stream.avail_in = inLen;
+        stream.next_out = reinterpret_cast<std::uint8_t*>(out);
+        stream.avail_out = outLeft;
+        auto res = LZMA_OK;
+        while (res == LZMA_OK && stream.avail_in > 0 && stream.avail_out > 0)
+            res = lzma_code(&stream, LZMA_RUN);
+        in += inLen - stream.avail_in;
+        inLen = stream.avail_in;
+        out += outLeft - stream.avail_out;
+        outLeft = stream.avail_out;
+        if (res == LZMA_MEMLIMIT_ERROR)
+            overMemLimit = true;
+        return res == LZMA_OK || res == LZMA_STREAM_END || res == LZMA_BUF_ERROR;
+    }
+    bool flush(char*& out, std::size_t& outLeft) override {
+        if (!ok)
+            return false;
+        stream.next_in = nullptr;
+        stream.avail_in = 0;
+        stream.next_out = reinterpret_cast<std::uint8_t*>(out);
+        stream.avail_out = outLeft;
+        auto res = LZMA_OK;
+        while (res == LZMA_OK && stream.avail_out > 0)
+            res = lzma_code(&stream, LZMA_FINISH);
+        out += outLeft - stream.avail_out;
+        outLeft = stream.avail_out;
+        // LZMA_BUF_ERROR: a truncated file, all its bytes are out
+        return res == LZMA_OK || res == LZMA_STREAM_END || res == LZMA_BUF_ERROR;
+    }
+
+private:
+    lzma_stream stream = LZMA_STREAM_INIT;
+    bool ok{ false };
+};
+#endif
+}
+
+Decompressor::Format Decompressor::formatOf(const char* data, std::size_t len)
+{
+    if (startsWith(data, len, "\x1f\x8b", 2))
+        return Format::Gzip;
+    if (startsWith(data, len, "\x28\xb5\x2f\xfd", 4))
+        return Format::Zstd;
+    if (startsWith(data, len, "\xfd" "7zXZ\x00", 6))
+        return Format::Xz;
+    return Format::None;
+}
+
+bool Decompressor::isSupported(Format format)
+{
+    switch (format) {
+#if defined(MMD_HAVE_ZLIB)
+    case Format::Gzip:
+    case Format::Deflate:
+        return true;
+#endif
+#if defined(MMD_HAVE_ZSTD)
+    case Format::Zstd:
+        return true;
+#endif
+#if defined(MMD_HAVE_LZMA)
+    case Format::Xz:
+        return true;
+#endif
+    default:
+        return false;
+    }
+}
+
+Decompressor::Decompressor(Format format, std::uint64_t memLimit)
+{
+    (void)memLimit;  // xz and zstd only
+    switch (format) {
+#if defined(MMD_HAVE_ZLIB)
+    case Format::Gzip:
+    case Format::Deflate:
+        codec = std::make_unique<GzipCodec>(format == Format::Deflate);
+        break;
+#endif
+#if defined(MMD_HAVE_ZSTD)
+    case Format::Zstd:
+        codec = std::make_unique<ZstdCodec>(memLimit);
+        break;
+#endif
+#if defined(MMD_HAVE_LZMA)
+    case Format::Xz:
+        codec = std::make_unique<XzCodec>(memLimit);
+        break;
+#endif
+    default:
+        break;
+    }
+}
+
+Decompressor::~Decompressor() = default;
+
+bool Decompressor::decompress(const char*& in, std::size_t& inLen, char*& out, std::size_t& outLeft)
+{
+    return codec && codec->decompress(in, inLen, out, outLeft);
+}
+
+bool Decompressor::flush(char*& out, std::size_t& outLeft)
+{
+    return codec && codec->flush(out, outLeft);
+}
+
+bool Decompressor::overMemLimit() const
+{
+    return codec && codec->overMemLimit;
+}
+
+}
@@ -0,0 +1,86 @@
+#pragma once
+//
+// Copyright (c) Milivoj (Mike) DAVIDOV
+//
+// THIS SOFTWARE IS PROVIDED "AS IS" WITHOUT WARRANTY OF ANY KIND,
+// EITHER EXPRESSED OR IMPLIED, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+// WARRANTIES OF MERCHANTABILITY AND/OR FITNESS FOR A PARTICULAR PURPOSE.
+//
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+namespace mmd
+{
+/// @brief Streaming decompression of gzip, zstd and xz files (and of raw
+/// deflate data, as in zip archives), one call per
+/// input window into a caller's output buffer, so that nothing but the
+/// library state (up to a few MB for most xz / zstd files) is allocated.
+/// That state is capped (the xz dictionary, the zstd window): a file that
+/// needs more is not decompressed (overMemLimit()), so a crafted file cannot
+/// make the app allocate any amount of memory.
+/// Concatenated streams (e.g. several gzip members, zstd frames) are
+/// decompressed one after another.
+/// Each format is only supported if the app was built with its library
+/// (zlib, libzstd, liblzma), see isSupported().
+/// @author Milivoj (Mike) DAVIDOV
+///
+class Decompressor
+{
+public:
+    enum class Format { None, Gzip, Zstd, Xz, Deflate };
+
+    /// Default cap of the decompressed bytes searched per file
+    static constexpr std::uint64_t DEFAULT_MAX_SIZE = std::uint64_t(1024) * 1024 * 1024;
+    /// Default cap of the library state: enough for all the xz presets and zstd levels
+    static constexpr std::uint64_t DEFAULT_MEM_LIMIT = std::uint64_t(128) * 1024 * 1024;
+
+    /// The format of a file that starts with @p data (by its magic number; not Deflate)
+    static Format formatOf(const char* data, std::size_t len);
+    static bool isSupported(Format format);
+
+    explicit Decompressor(Format format, std::uint64_t memLimit = DEFAULT_MEM_LIMIT);
+    ~Decompressor();
+    Decompressor(const Decompressor&) = delete;
+    Decompressor& operator=(const Decompressor&) = delete;
+
+    /// @brief Decompresses from @p in into @p out, advancing both
+    /// (and decreasing @p inLen and @p outLeft) until either is used up.
+    /// @return false if the data is corrupt (or the format not supported).
+    bool decompress(const char*& in, std::size_t& inLen, char*& out, std::size_t& outLeft);
+    /// @brief At the end of the input: the decompressed bytes the decoder still
+    /// holds, into @p out, as many as fit; called again while @p outLeft ends at 0.
+    /// @return false if the data is corrupt (or the format not supported).
+    bool flush(char*& out, std::size_t& outLeft);
+    /// Whether decompress() failed as the data needs more memory than the limit
+    bool overMemLimit() const;
+
+    struct Codec;
+
+private:
+    std::unique_ptr<Codec> codec;
+};
+
+/// Decompressed files, bytes and time, summed over all the content readers
+struct DecompressionStats
+{
+    std::atomic<std::uint64_t> nbrFiles{ 0 };
+    std::atomic<std::uint64_t> nbrBytes{ 0 };        // decompressed
+    std::atomic<std::uint64_t> nanoseconds{ 0 };     // thread time spent decompressing
+    std::atomic<std::uint64_t> nbrOverLimit{ 0 };    // files not searched: over the memory limit
+
+    void reset() {
+        nbrFiles = 0;
+        nbrBytes = 0;
+        nanoseconds = 0;
+        nbrOverLimit = 0;
+    }
+    /// Decompressed MB per second of one thread (core)
+    double mbPerSecond() const {
+        return nanoseconds > 0 ? double(nbrBytes) * 1000.0 / double(nanoseconds) : 0.0;
+    }
+};
+
+}
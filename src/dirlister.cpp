@@ -0,0 +1,101 @@
+//
+// Copyright (c) Milivoj (Mike) DAVIDOV
+//
+// THIS SOFTWARE IS PROVIDED "AS IS" WITHOUT WARRANTY OF ANY KIND,
+// EITHER EXPRESSED OR IMPLIED, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+// WARRANTIES OF MERCHANTABILITY AND/OR FITNESS FOR A PARTICULAR PURPOSE.
+//
+
+#include "dirlister.hpp"
+#include "folderscanner.hpp"
+#if defined(Q_OS_LINUX)
+#include "dirlister_linux.hpp"
+#endif
+#include <QDir>
+#include <QFileInfo>
+
+namespace mmd
+{
+DirLister::DirLister(const ScanParams& scanParams)
+    : params(scanParams)
+    , typeFilter(scanParams.itemTypeFilter)
+    , nameFilter(scanParams.nameFilters, scanParams.regex, scanParams.wholeWords)
+{
+    // No item type at all (e.g. get size) means all types, as for QDir
+    if (!(typeFilter & QDir::TypeMask))
+        typeFilter |= QDir::AllEntries;
+}
+
+std::unique_ptr<DirLister> DirLister::create(const ScanParams& params, StatFields fields)
+{
+#if defined(Q_OS_LINUX)
+    if (!params.qtDirListing && LinuxDirLister::isSupported())
+        return std::make_unique<LinuxDirLister>(params, fields);
+#endif
+    (void)fields; // QFileInfo has all of them anyway
+    return std::make_unique<DirLister>(params);
+}
+
+bool DirLister::matchesType(FsEntry::Type type) const
+{
+    switch (type) {
+    case FsEntry::Type::Symlink:
+        if (typeFilter & QDir::NoSymLinks)
+            return false;
+        break;
+    case FsEntry::Type::Dir:
+        if (!(typeFilter & QDir::Dirs))
+            return false;
+        break;
+    case FsEntry::Type::File:
+        if (!(typeFilter & QDir::Files))
+            return false;
+        break;
+    case FsEntry::Type::Other:
+        if (!(typeFilter & QDir::System))
+            return false;
+        break;
+    }
+    return true;
+}
+
+bool DirLister::list(const QString& dirPath, DirListing& out) const
+{
+    out.clear();
+    // One read of the directory: everything except . and ..
+    // (hidden entries only if not excluded), classified below.
+    QDir dir(dirPath);
+    auto filters = QDir::AllEntries | QDir::AllDirs | QDir::Drives | QDir::System | QDir::NoDotAndDotDot;
+    if (!params.exclHidden)
+        filters |= QDir::Hidden;
+    const auto infos = dir.entryInfoList(filters);
+    out.subDirs.reserve(size_t(infos.size()));
+    out.candidates.reserve(size_t(infos.size()));
+    for (const auto& info : infos) {
+        FsEntry entry;
+        entry.path = info.absoluteFilePath();
+        entry.name = info.fileName();
+        entry.hidden = info.isHidden();
+        if (isSymbolic(info))
+            entry.type = FsEntry::Type::Symlink;
+        else if (info.isDir())
+            entry.type = FsEntry::Type::Dir;
+        else if (info.isFile())
+            entry.type = FsEntry::Type::File;
+        entry.info = info;
+        const auto candidate = isCandidate(entry.type, entry.name);
+        if (isArchive(entry.type, entry.name))
+            out.archives.push_back(entry);
+        if (entry.isDir()) {
+            if (candidate)
+                out.candidates.push_back(entry);
+            out.subDirs.push_back(std::move(entry));
+        }
+        else if (candidate) {
+            out.candidates.push_back(std::move(entry));
+        }
+    }
+    return true;
+}
+
+}
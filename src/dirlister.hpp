@@ -0,0 +1,130 @@
+#pragma once
+//
+// Copyright (c) Milivoj (Mike) DAVIDOV
+//
+// THIS SOFTWARE IS PROVIDED "AS IS" WITHOUT WARRANTY OF ANY KIND,
+// EITHER EXPRESSED OR IMPLIED, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+// WARRANTIES OF MERCHANTABILITY AND/OR FITNESS FOR A PARTICULAR PURPOSE.
+//
+
+#include "archivereader.hpp"
+#include "namefilter.hpp"
+#include "scanparams.hpp"
+#include <memory>
+#include <vector>
+#include <QDir>
+#include <QFileInfo>
+#include <QString>
+
+namespace mmd
+{
+/// @brief One directory entry as classified by a DirLister.
+/// The QFileInfo is created lazily by fileInfo(), so that entries
+/// which are filtered out never cost a QFileInfo (or a stat).
+/// @author Milivoj (Mike) DAVIDOV
+///
+struct FsEntry
+{
+    enum class Type : quint8 { Other, File, Dir, Symlink };
+
+    QString path;  // absolute, with '/' separators
+    QString name;
+    Type type{ Type::Other };
+    bool hidden{ false };
+    qint64 size{ -1 };     // -1 if not known yet
+    qint64 mtime{ -1 };    // msec since epoch, -1 if not known yet
+    qint64 ownerId{ -1 };  // user id, -1 if not known yet
+    std::shared_ptr<const ArchiveMember> member;  // if in an archive (path is "archive!/name")
+
+    bool isDir() const { return type == Type::Dir; }
+    bool isFile() const { return type == Type::File; }
+    bool isSymlink() const { return type == Type::Symlink; }
+    qint64 fileSize() const { return size >= 0 ? size : fileInfo().size(); }
+
+    const QFileInfo& fileInfo() const {
+        if (info.filePath().isEmpty())
+            info = QFileInfo(path);
+        return info;
+    }
+
+    mutable QFileInfo info;
+};
+
+/// @brief Result of listing one directory: the sub-directories
+/// to descend into, and the entries that match the item type and
+/// name filters (the candidates for the search results), and the archives
+/// to search inside (if ScanParams::searchArchives).
+/// An entry can be in more than one list.
+///
+struct DirListing
+{
+    std::vector<FsEntry> subDirs;
+    std::vector<FsEntry> candidates;
+    std::vector<FsEntry> archives;
+
+    void clear() {
+        subDirs.clear();
+        candidates.clear();
+        archives.clear();
+    }
+};
+
+/// @brief DirLister reads each directory only once and classifies its
+/// entries in memory, applying ScanParams::itemTypeFilter and ScanParams::nameFilters
+/// to the candidates. Sub-directories ignore the name filters (like QDir::AllDirs)
+/// and never include symlinks, so the whole structure is traversed.
+/// This replaces the previous two listings per directory
+/// (one for the sub-directories and one for the name-filtered items).
+/// It is stateless and can be shared by several threads.
+/// @author Milivoj (Mike) DAVIDOV
+///
+class DirLister
+{
+public:
+    /// Entry metadata that a caller needs for (almost) every candidate,
+    /// so a backend can fetch it while listing.
+    enum StatField : unsigned {
+        StatNone  = 0,
+        StatSize  = 1,
+        StatMTime = 2,
+        StatOwner = 4,
+    };
+    using StatFields = unsigned;
+
+    explicit DirLister(const ScanParams& params);
+    virtual ~DirLister() = default;
+
+    /// @brief Creates the fastest backend available at runtime:
+    /// the native one on Linux (unless ScanParams::qtDirListing is set
+    /// or the kernel does not support it), otherwise the portable QDir one.
+    static std::unique_ptr<DirLister> create(const ScanParams& params, StatFields fields = StatNone);
+
+    /// @brief Lists @p dirPath into @p out (which is cleared first).
+    /// @return false if the directory could not be read.
+    virtual bool list(const QString& dirPath, DirListing& out) const;
+
+protected:
+    bool matchesType(FsEntry::Type type) const;
+    bool isCandidate(FsEntry::Type type, const QString& name) const {
+        return matchesType(type) && nameFilter.matches(name);
+    }
+    /// @p name is UTF-8, so it does not need to be decoded to be filtered out
+    bool isCandidate(FsEntry::Type type, const char* name, std::size_t len) const {
+        return matchesType(type) && nameFilter.matches(name, len);
+    }
+    /// A zip or tar file to list as a virtual folder
+    bool isArchive(FsEntry::Type type, const QString& name) const {
+        return params.searchArchives && type == FsEntry::Type::File &&
+               ArchiveReader::kindOf(name) != ArchiveReader::Kind::None;
+    }
+    bool isArchive(FsEntry::Type type, const char* name, std::size_t len) const {
+        return params.searchArchives && type == FsEntry::Type::File &&
+               ArchiveReader::kindOf(name, len) != ArchiveReader::Kind::None;
+    }
+
+    const ScanParams& params;
+    QDir::Filters typeFilter;
+    NameFilter nameFilter;
+};
+
+}
@@ -0,0 +1,234 @@
+//
+// Copyright (c) Milivoj (Mike) DAVIDOV
+//
+// THIS SOFTWARE IS PROVIDED "AS IS" WITHOUT WARRANTY OF ANY KIND,
+// EITHER EXPRESSED OR IMPLIED, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+// WARRANTIES OF MERCHANTABILITY AND/OR FITNESS FOR A PARTICULAR PURPOSE.
+//
+
+#include "dirlister_linux.hpp"
+#include "uringstatx_linux.hpp"
+#include <cerrno>
+#include <cstring>
+#include <dirent.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <sys/statfs.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#include <QFile>
+
+namespace mmd
+{
+namespace
+{
+/// Layout of the records returned by getdents64(2)
+struct LinuxDirent64 {
+    quint64        d_ino;
+    qint64         d_off;
+    unsigned short d_reclen;
+    unsigned char  d_type;
+    char           d_name[1];
+};
+
+/// RAII file descriptor
+class Fd {
+public:
+    explicit Fd(int fd) : fd_(fd) {}
+    ~Fd() { if (fd_ >= 0) ::close(fd_); }
+    Fd(const Fd&) = delete;
+    Fd& operator=(const Fd&) = delete;
+    int get() const { return fd_; }
+private:
+    int fd_;
+};
+
+FsEntry::Type typeFromDirent(unsigned char dtype)
+{
+    switch (dtype) {
+    case DT_DIR: return FsEntry::Type::Dir;
+    case DT_REG: return FsEntry::Type::File;
+    case DT_LNK: return FsEntry::Type::Symlink;
+    default:     return FsEntry::Type::Other;
+    }
+}
+
+FsEntry::Type typeFromMode(unsigned mode)
+{
+    if (S_ISDIR(mode)) return FsEntry::Type::Dir;
+    if (S_ISREG(mode)) return FsEntry::Type::File;
+    if (S_ISLNK(mode)) return FsEntry::Type::Symlink;
+    return FsEntry::Type::Other;
+}
+
+qint64 toMsec(const struct statx_timestamp& ts)
+{
+    return qint64(ts.tv_sec) * 1000 + qint64(ts.tv_nsec / 1'000'000);
+}
+
+void setStatFields(FsEntry& entry, const struct statx& stx)
+{
+    if (stx.stx_mask & STATX_SIZE)
+        entry.size = qint64(stx.stx_size);
+    if (stx.stx_mask & STATX_MTIME)
+        entry.mtime = toMsec(stx.stx_mtime);
+    if (stx.stx_mask & STATX_UID)
+        entry.ownerId = qint64(stx.stx_uid);
+}
+}
+
+LinuxDirLister::LinuxDirLister(const ScanParams& scanParams, StatFields fields)
+    : DirLister(scanParams)
+    , statxMask(0)
+    , batchStat(false)
+{
+    if (fields & StatSize)
+        statxMask |= STATX_SIZE;
+    if (fields & StatMTime)
+        statxMask |= STATX_MTIME;
+    if (fields & StatOwner)
+        statxMask |= STATX_UID;
+    batchStat = statxMask != 0 && !scanParams.syncStat &&
+                (scanParams.uringStat || isNetworkFs(scanParams.origDirPath));
+}
+
+bool LinuxDirLister::isNetworkFs(const QString& path)
+{
+    struct statfs sfs;
+    if (path.isEmpty() || ::statfs(QFile::encodeName(path).constData(), &sfs) != 0)
+        return false;
+    switch (static_cast<unsigned long>(sfs.f_type)) {
+    case 0x6969:      // NFS
+    case 0x517B:      // SMB
+    case 0xFF534D42:  // CIFS
+    case 0xFE534D42:  // SMB2
+    case 0x65735546:  // FUSE (sshfs, ...)
+    case 0x00C36400:  // Ceph
+    case 0x5346414F:  // AFS
+    case 0x01161970:  // GFS2
+    case 0x47504653:  // GPFS
+    case 0x0BD00BD0:  // Lustre
+        return true;
+    default:
+        return false;
+    }
+}
+
+bool LinuxDirLister::isSupported()
+{
+    static const bool supported = []() {
+        // An invalid fd must give EBADF, not ENOSYS (or EPERM from seccomp)
+        errno = 0;
+        const auto rc = ::syscall(SYS_getdents64, -1, nullptr, 0);
+        if (rc >= 0 || errno != EBADF)
+            return false;
+        struct statx stx;
+        return ::statx(AT_FDCWD, "/", 0, STATX_TYPE, &stx) == 0;
+    }();
+    return supported;
+}
+
+bool LinuxDirLister::list(const QString& dirPath, DirListing& out) const
+{
+    out.clear();
+    const auto dirPathBytes = QFile::encodeName(dirPath);
+    const Fd dirFd(::open(dirPathBytes.constData(), O_RDONLY | O_DIRECTORY | O_CLOEXEC));
+    if (dirFd.get() < 0)
+        return false;
+
+    auto prefix = dirPath;
+    if (!prefix.endsWith(QLatin1Char('/')))
+        prefix += QLatin1Char('/');
+
+    // statx of the candidates of one getdents buffer, done before the buffer is reused
+    std::vector<const char*> statNames;
+    std::vector<size_t> statIdx;  // into out.candidates
+    std::vector<struct statx> stats;
+    std::vector<int> statResults;
+    const auto statPending = [&]() {
+        if (statNames.empty())
+            return;
+        if (batchStat)
+            UringStatx::forThread().statBatch(dirFd.get(), statNames, statxMask, stats, statResults);
+        else
+            UringStatx::statSync(dirFd.get(), statNames, statxMask, stats, statResults);
+        for (size_t i = 0; i < statNames.size(); ++i) {
+            if (statResults[i] == 0)
+                setStatFields(out.candidates[statIdx[i]], stats[i]);
+        }
+        statNames.clear();
+        statIdx.clear();
+    };
+
+    alignas(LinuxDirent64) char buf[64 * 1024];
+    for (;;) {
+        const auto nread = ::syscall(SYS_getdents64, dirFd.get(), buf, sizeof(buf));
+        if (nread == 0)
+            break;
+        if (nread < 0) {
+            if (errno == EINTR)
+                continue;
+            if (errno == ENOSYS || errno == EINVAL)
+                return DirLister::list(dirPath, out);
+            statPending();
+            return !out.subDirs.empty() || !out.candidates.empty();
+        }
+        for (long pos = 0; pos < nread; ) {
+            const auto* d = reinterpret_cast<const LinuxDirent64*>(buf + pos);
+            pos += d->d_reclen;
+            const char* cname = d->d_name;
+            if (cname[0] == '.' && (cname[1] == '\0' || (cname[1] == '.' && cname[2] == '\0')))
+                continue;
+            const auto hidden = (cname[0] == '.');
+            if (hidden && params.exclHidden)
+                continue;
+
+            auto type = typeFromDirent(d->d_type);
+            struct statx stx;
+            auto haveStx = false;
+            if (d->d_type == DT_UNKNOWN) {
+                // Some file systems (e.g. older XFS, some FUSE) don't fill d_type
+                if (::statx(dirFd.get(), cname, AT_SYMLINK_NOFOLLOW, STATX_TYPE | statxMask, &stx) != 0)
+                    continue;
+                type = typeFromMode(stx.stx_mode);
+                haveStx = true;
+            }
+
+            const auto nameLen = std::strlen(cname);
+            const auto candidate = isCandidate(type, cname, nameLen);
+            const auto archive = isArchive(type, cname, nameLen);
+            if (!candidate && !archive && type != FsEntry::Type::Dir)
+                continue;
+            FsEntry entry;
+            entry.name = QFile::decodeName(cname);
+            entry.path = prefix + entry.name;
+            entry.type = type;
+            entry.hidden = hidden;
+
+            if (candidate && statxMask != 0) {
+                if (haveStx) {
+                    setStatFields(entry, stx);
+                }
+                else {
+                    statNames.push_back(cname);
+                    statIdx.push_back(out.candidates.size());
+                }
+            }
+
+            if (archive)
+                out.archives.push_back(entry);
+            if (type == FsEntry::Type::Dir) {
+                if (candidate)
+                    out.candidates.push_back(entry);
+                out.subDirs.push_back(std::move(entry));
+            }
+            else if (candidate) {
+                out.candidates.push_back(std::move(entry));
+            }
+        }
+        statPending();
+    }
+    return true;
+}
+
+}
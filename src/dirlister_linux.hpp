@@ -0,0 +1,46 @@
+#pragma once
+//
+// Copyright (c) Milivoj (Mike) DAVIDOV
+//
+// THIS SOFTWARE IS PROVIDED "AS IS" WITHOUT WARRANTY OF ANY KIND,
+// EITHER EXPRESSED OR IMPLIED, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+// WARRANTIES OF MERCHANTABILITY AND/OR FITNESS FOR A PARTICULAR PURPOSE.
+//
+
+#include "dirlister.hpp"
+
+namespace mmd
+{
+/// @brief Linux DirLister backend.
+/// It reads directories with getdents64() on a directory fd and takes
+/// the entry type from d_type, so no stat is needed just for names.
+/// statx() (relative to the directory fd, with only the requested
+/// fields in the mask) is called for candidates only when the caller
+/// asked for size, modification time or owner, and for the rare
+/// entries whose d_type is DT_UNKNOWN.
+/// When stat fields are needed and io_uring batching is on (ScanParams::uringStat,
+/// or automatically for network file systems), the statx calls of a getdents
+/// buffer are submitted together through UringStatx.
+/// Falls back to the portable QDir listing if getdents64 is not available.
+/// @author Milivoj (Mike) DAVIDOV
+///
+class LinuxDirLister : public DirLister
+{
+public:
+    LinuxDirLister(const ScanParams& scanParams, StatFields fields);
+
+    /// Returns false if getdents64() or statx() cannot be used
+    /// (e.g. blocked by a seccomp filter or a very old kernel).
+    static bool isSupported();
+
+    bool list(const QString& dirPath, DirListing& out) const override;
+
+    /// NFS, SMB/CIFS, FUSE, Ceph, ...: where metadata latency dominates.
+    static bool isNetworkFs(const QString& path);
+
+private:
+    unsigned int statxMask;
+    bool batchStat;
+};
+
+}
@@ -0,0 +1,26 @@
+//
+// Copyright (c) Milivoj (Mike) DAVIDOV
+//
+// THIS SOFTWARE IS PROVIDED "AS IS" WITHOUT WARRANTY OF ANY KIND,
+// EITHER EXPRESSED OR IMPLIED, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+// WARRANTIES OF MERCHANTABILITY AND/OR FITNESS FOR A PARTICULAR PURPOSE.
+//
+
+#include "dirwatcher.hpp"
+#if defined(Q_OS_LINUX)
+#include "dirwatcher_linux.hpp"
+#endif
+
+namespace mmd
+{
+std::unique_ptr<DirWatcher> DirWatcher::create()
+{
+#if defined(Q_OS_LINUX)
+    return InotifyWatcher::create();
+#else
+    // Folders are validated by their modification time only
+    return nullptr;
+#endif
+}
+
+}
@@ -0,0 +1,45 @@
+#pragma once
+//
+// Copyright (c) Milivoj (Mike) DAVIDOV
+//
+// THIS SOFTWARE IS PROVIDED "AS IS" WITHOUT WARRANTY OF ANY KIND,
+// EITHER EXPRESSED OR IMPLIED, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+// WARRANTIES OF MERCHANTABILITY AND/OR FITNESS FOR A PARTICULAR PURPOSE.
+//
+
+#include <memory>
+#include <QString>
+
+namespace mmd
+{
+/// @brief DirWatcher keeps track of the indexed folders that may have
+/// changed since they were read, using the OS change notifications.
+/// A folder is "clean" from watch() on, until anything in it (an entry
+/// created, deleted, renamed, written or its attributes changed) or the
+/// folder itself changes. The index can then serve a clean folder without
+/// touching the disk at all; all the other folders are validated by their
+/// modification time (e.g. when the OS watch limit is reached).
+/// All members are thread-safe.
+/// @author Milivoj (Mike) DAVIDOV
+///
+class DirWatcher
+{
+public:
+    virtual ~DirWatcher() = default;
+
+    /// @brief Creates the watcher for this platform.
+    /// @return nullptr where change notifications are not supported.
+    static std::unique_ptr<DirWatcher> create();
+
+    /// @brief Starts watching @p dirPath (if not watched yet).
+    /// Call it before reading the folder, so that no change can be missed.
+    virtual void watch(const QString& dirPath) = 0;
+
+    /// Returns true if @p dirPath is watched and has not changed since watch().
+    virtual bool isClean(const QString& dirPath) const = 0;
+
+    /// Stops watching everything (all folders become not clean).
+    virtual void reset() = 0;
+};
+
+}
@@ -0,0 +1,186 @@
+//
+// Copyright (c) Milivoj (Mike) DAVIDOV
+//
+// THIS SOFTWARE IS PROVIDED "AS IS" WITHOUT WARRANTY OF ANY KIND,
+// EITHER EXPRESSED OR IMPLIED, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+// WARRANTIES OF MERCHANTABILITY AND/OR FITNESS FOR A PARTICULAR PURPOSE.
+//
+
+#include "dirwatcher_linux.hpp"
+#include "set_thread_name.hpp"
+#include <cerrno>
+#include <mutex>
+#include <poll.h>
+#include <sys/inotify.h>
+#include <unistd.h>
+#include <QFile>
+#include <QDebug>
+
+namespace mmd
+{
+namespace
+{
+// Anything that changes the entries of a folder, or their size, mtime or attributes
+constexpr quint32 WATCH_MASK = IN_CREATE | IN_DELETE | IN_MOVED_FROM | IN_MOVED_TO |
+                               IN_MODIFY | IN_ATTRIB | IN_DELETE_SELF | IN_MOVE_SELF |
+                               IN_ONLYDIR | IN_DONT_FOLLOW | IN_EXCL_UNLINK;
+
+// Used when /proc/sys/fs/inotify/max_user_watches cannot be read (the old kernel default)
+constexpr std::size_t DEFAULT_MAX_USER_WATCHES = 8192;
+
+std::size_t maxUserWatches()
+{
+    QFile file(QStringLiteral("/proc/sys/fs/inotify/max_user_watches"));
+    if (!file.open(QIODevice::ReadOnly))
+        return DEFAULT_MAX_USER_WATCHES;
+    bool ok = false;
+    const auto value = file.readAll().trimmed().toULongLong(&ok);
+    return ok && value > 0 ? std::size_t(value) : DEFAULT_MAX_USER_WATCHES;
+}
+
+QString childPath(const QString& dirPath, const QString& name)
+{
+    return dirPath.endsWith(QLatin1Char('/')) ? dirPath + name : dirPath + QChar('/') + name;
+}
+}
+
+std::unique_ptr<InotifyWatcher> InotifyWatcher::create()
+{
+    const int fd = ::inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    if (fd < 0)
+        return nullptr;
+    // The watches count against a per-user limit shared with IDEs, file
+    // managers and systemd path units, so half of it is left to them
+    return std::unique_ptr<InotifyWatcher>(new InotifyWatcher(fd, maxUserWatches() / 2));
+}
+
+InotifyWatcher::InotifyWatcher(int fd, std::size_t maxWatches)
+    : inotifyFd(fd)
+    , watchCap(maxWatches)
+    , watchLimit(maxWatches)
+{
+    reader = std::jthread([this](std::stop_token stop) { readEvents(stop); });
+}
+
+InotifyWatcher::~InotifyWatcher()
+{
+    reader.request_stop();
+    if (reader.joinable())
+        reader.join();
+    ::close(inotifyFd);  // also removes all the watches
+}
+
+void InotifyWatcher::watch(const QString& dirPath)
+{
+    {
+        std::shared_lock<std::shared_mutex> lock(mutex);
+        if (pathWds.contains(dirPath) || pathWds.size() >= watchLimit)
+            return;
+    }
+    const int wd = ::inotify_add_watch(inotifyFd, QFile::encodeName(dirPath).constData(), WATCH_MASK);
+    const int addError = errno;
+    std::unique_lock<std::shared_mutex> lock(mutex);
+    if (wd < 0) {
+        // Other apps took more than their share of max_user_watches
+        if (addError == ENOSPC && watchLimit > pathWds.size()) {
+            watchLimit = pathWds.size();
+            qDebug() << "inotify watch limit reached at" << watchLimit << "folders,"
+                     << "the others are validated by their modification time";
+        }
+        return;
+    }
+    // The same folder under another path (it was renamed, or a bind mount)
+    const auto it = wdPaths.find(wd);
+    if (it == wdPaths.end() && pathWds.size() >= watchLimit) {
+        // Other scanner threads filled the cap meanwhile
+        ::inotify_rm_watch(inotifyFd, wd);
+        return;
+    }
+    if (it != wdPaths.end() && it->second != dirPath)
+        pathWds.erase(it->second);
+    wdPaths[wd] = dirPath;
+    pathWds[dirPath] = wd;
+}
+
+bool InotifyWatcher::isClean(const QString& dirPath) const
+{
+    std::shared_lock<std::shared_mutex> lock(mutex);
+    return pathWds.contains(dirPath);
+}
+
+void InotifyWatcher::reset()
+{
+    std::unique_lock<std::shared_mutex> lock(mutex);
+    unwatchAll();
+    watchLimit = watchCap;
+}
+
+void InotifyWatcher::unwatch(int wd)
+{
+    const auto it = wdPaths.find(wd);
+    if (it == wdPaths.end())
+        return;
+    pathWds.erase(it->second);
+    wdPaths.erase(it);
+    ::inotify_rm_watch(inotifyFd, wd);
+}
+
+void InotifyWatcher::unwatchSubtree(const QString& dirPath)
+{
+    const auto prefix = childPath(dirPath, QString());
+    auto it = pathWds.lower_bound(dirPath);
+    while (it != pathWds.end() && (it->first == dirPath || it->first.startsWith(prefix))) {
+        wdPaths.erase(it->second);
+        ::inotify_rm_watch(inotifyFd, it->second);
+        it = pathWds.erase(it);
+    }
+}
+
+void InotifyWatcher::unwatchAll()
+{
+    for (const auto& [path, wd] : pathWds)
+        ::inotify_rm_watch(inotifyFd, wd);
+    pathWds.clear();
+    wdPaths.clear();
+}
+
+void InotifyWatcher::readEvents(std::stop_token stop)
+{
+    set_thread_name("DirWatcher");
+    alignas(inotify_event) char buf[64 * 1024];
+    pollfd pfd{ inotifyFd, POLLIN, 0 };
+    while (!stop.stop_requested()) {
+        if (::poll(&pfd, 1, 250) <= 0)  // msec; timeout or EINTR
+            continue;
+        const auto nread = ::read(inotifyFd, buf, sizeof(buf));
+        if (nread <= 0)
+            continue;
+        std::unique_lock<std::shared_mutex> lock(mutex);
+        for (long pos = 0; pos < nread; ) {
+            const auto* ev = reinterpret_cast<const inotify_event*>(buf + pos);
+            pos += long(sizeof(inotify_event) + ev->len);
+            if (ev->mask & IN_Q_OVERFLOW) {
+                // Events were lost, so no folder can be trusted
+                unwatchAll();
+                continue;
+            }
+            const auto it = wdPaths.find(ev->wd);
+            if (it == wdPaths.end())
+                continue;  // already changed (or IN_IGNORED after unwatch)
+            const auto dirPath = it->second;
+            if (ev->mask & (IN_DELETE_SELF | IN_MOVE_SELF | IN_IGNORED)) {
+                // The sub-folders' paths are gone too
+                unwatchSubtree(dirPath);
+                continue;
+            }
+            if ((ev->mask & IN_ISDIR) && ev->len > 0 &&
+                (ev->mask & (IN_DELETE | IN_MOVED_FROM | IN_MOVED_TO | IN_CREATE))) {
+                unwatchSubtree(childPath(dirPath, QFile::decodeName(ev->name)));
+            }
+            // Coalesce: no more events from this folder until it is read and watched again
+            unwatch(ev->wd);
+        }
+    }
+}
+
+}
@@ -0,0 +1,58 @@
+#pragma once
+//
+// Copyright (c) Milivoj (Mike) DAVIDOV
+//
+// THIS SOFTWARE IS PROVIDED "AS IS" WITHOUT WARRANTY OF ANY KIND,
+// EITHER EXPRESSED OR IMPLIED, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+// WARRANTIES OF MERCHANTABILITY AND/OR FITNESS FOR A PARTICULAR PURPOSE.
+//
+
+#include "dirwatcher.hpp"
+#include <cstddef>
+#include <map>
+#include <memory>
+#include <shared_mutex>
+#include <thread>
+#include <unordered_map>
+#include <QString>
+
+namespace mmd
+{
+/// @brief inotify DirWatcher (fanotify would need CAP_SYS_ADMIN).
+/// Events are coalesced per folder: the first event from a folder removes
+/// its watch, so a folder costs one event until it is read and watched
+/// again, however many files a build touches in it.
+/// A queue overflow drops all watches. At most half of the user's inotify
+/// watch limit (max_user_watches) is used, leaving the rest to other apps;
+/// further folders are simply not watched, i.e. they are validated by their
+/// modification time when read.
+/// @author Milivoj (Mike) DAVIDOV
+///
+class InotifyWatcher : public DirWatcher
+{
+public:
+    /// Returns nullptr if inotify is not available.
+    static std::unique_ptr<InotifyWatcher> create();
+    ~InotifyWatcher() override;
+
+    void watch(const QString& dirPath) override;
+    bool isClean(const QString& dirPath) const override;
+    void reset() override;
+
+private:
+    InotifyWatcher(int fd, std::size_t maxWatches);
+    void readEvents(std::stop_token stop);
+    void unwatch(int wd);                          // mutex must be locked
+    void unwatchSubtree(const QString& dirPath);   // mutex must be locked
+    void unwatchAll();                             // mutex must be locked
+
+    const int inotifyFd;
+    mutable std::shared_mutex mutex;
+    std::map<QString, int> pathWds;  // ordered, for sub-trees
+    std::unordered_map<int, QString> wdPaths;
+    const std::size_t watchCap;  // own share of max_user_watches
+    std::size_t watchLimit;      // lower if ENOSPC came first
+    std::jthread reader;
+};
+
+}
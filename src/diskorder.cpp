@@ -0,0 +1,104 @@
+//
+// Copyright (c) Milivoj (Mike) DAVIDOV
+//
+// THIS SOFTWARE IS PROVIDED "AS IS" WITHOUT WARRANTY OF ANY KIND,
+// EITHER EXPRESSED OR IMPLIED, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+// WARRANTIES OF MERCHANTABILITY AND/OR FITNESS FOR A PARTICULAR PURPOSE.
+//
+
+#include "diskorder.hpp"
+#include "archivereader.hpp"
+#include <algorithm>
+#include <map>
+#include <utility>
+#include <QFile>
+#if defined(Q_OS_LINUX)
+#include <fcntl.h>
+#include <linux/fiemap.h>
+#include <linux/fs.h>
+#include <sys/ioctl.h>
+#include <sys/stat.h>
+#include <sys/sysmacros.h>
+#include <unistd.h>
+#endif
+
+namespace mmd
+{
+bool DiskOrder::isRotational(const QString& path)
+{
+#if defined(Q_OS_LINUX)
+    struct stat st;
+    if (path.isEmpty() || ::stat(QFile::encodeName(path).constData(), &st) != 0)
+        return false;
+    // A partition has no queue/ of its own: its parent folder is the disk
+    const auto device = QStringLiteral("/sys/dev/block/%1:%2/").arg(major(st.st_dev)).arg(minor(st.st_dev));
+    for (const auto& queue : { QStringLiteral("queue/rotational"), QStringLiteral("../queue/rotational") }) {
+        QFile file(device + queue);
+        if (file.open(QIODevice::ReadOnly))
+            return file.readAll().trimmed() == "1";
+    }
+    return false;
+#else
+    (void)path;
+    return false;
+#endif
+}
+
+DiskOrder::Place DiskOrder::placeOf(const QString& path)
+{
+    Place place;
+#if defined(Q_OS_LINUX)
+    const auto fd = ::open(QFile::encodeName(path).constData(), O_RDONLY | O_CLOEXEC | O_NOFOLLOW);
+    if (fd < 0)
+        return place;
+    struct stat st;
+    if (::fstat(fd, &st) == 0) {
+        place.device = quint64(st.st_dev);
+        place.kind = Place::Inode;
+        place.position = quint64(st.st_ino);
+    }
+    // Only the first extent; no FIEMAP_FLAG_SYNC, which would write dirty pages
+    alignas(struct fiemap) char request[sizeof(struct fiemap) + sizeof(struct fiemap_extent)]{};
+    auto* map = reinterpret_cast<struct fiemap*>(request);
+    map->fm_length = FIEMAP_MAX_OFFSET;
+    map->fm_extent_count = 1;
+    if (place.kind == Place::Inode && ::ioctl(fd, FS_IOC_FIEMAP, map) == 0 && map->fm_mapped_extents > 0
+        && !(map->fm_extents[0].fe_flags & (FIEMAP_EXTENT_UNKNOWN | FIEMAP_EXTENT_DATA_INLINE))) {
+        place.kind = Place::Physical;
+        place.position = map->fm_extents[0].fe_physical;
+    }
+    ::close(fd);
+#else
+    (void)path;
+#endif
+    return place;
+}
+
+void DiskOrder::sort(std::vector<FsEntry>& files)
+{
+    // The members of an archive are after its place, by offset
+    std::map<QString, Place> archives;
+    std::vector<std::pair<std::pair<Place, quint64>, std::size_t>> keys;
+    keys.reserve(files.size());
+    for (std::size_t i = 0; i < files.size(); ++i) {
+        const auto& file = files[i];
+        if (file.member) {
+            auto it = archives.find(file.member->archivePath);
+            if (it == archives.end())
+                it = archives.emplace(file.member->archivePath, placeOf(file.member->archivePath)).first;
+            keys.push_back({ { it->second, file.member->offset }, i });
+        }
+        else {
+            keys.push_back({ { placeOf(file.path), 0 }, i });
+        }
+    }
+    std::stable_sort(keys.begin(), keys.end(),
+        [](const auto& a, const auto& b) { return a.first < b.first; });
+    std::vector<FsEntry> sorted;
+    sorted.reserve(files.size());
+    for (const auto& key : keys)
+        sorted.push_back(std::move(files[key.second]));
+    files.swap(sorted);
+}
+
+}
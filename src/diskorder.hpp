@@ -0,0 +1,51 @@
+#pragma once
+//
+// Copyright (c) Milivoj (Mike) DAVIDOV
+//
+// THIS SOFTWARE IS PROVIDED "AS IS" WITHOUT WARRANTY OF ANY KIND,
+// EITHER EXPRESSED OR IMPLIED, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+// WARRANTIES OF MERCHANTABILITY AND/OR FITNESS FOR A PARTICULAR PURPOSE.
+//
+
+#include "dirlister.hpp"
+#include <compare>
+#include <vector>
+#include <QString>
+
+namespace mmd
+{
+/// @brief Orders files for reading by where they are on the disk, so that
+/// a rotational disk reads a batch of them in one sweep of its heads
+/// instead of seeking back and forth in folder listing order.
+/// The place of a file is its first physical extent (FIEMAP), or its inode
+/// number where the file system does not map extents (inodes are mostly
+/// allocated near the data); archive members are ordered by their offset
+/// in the archive. Linux only: elsewhere the order is left as it is.
+/// @author Milivoj (Mike) DAVIDOV
+///
+class DiskOrder
+{
+public:
+    /// Whether @p path is on a rotational disk (/sys/dev/block/<major>:<minor>/queue/rotational,
+    /// or the disk's, for a partition); false if it cannot be told (e.g. network or virtual file systems).
+    static bool isRotational(const QString& path);
+
+    /// Sorts @p files by their place on the disk; those whose place
+    /// cannot be told keep their order, after the others.
+    static void sort(std::vector<FsEntry>& files);
+
+private:
+    /// Sort key of a file: physical byte (or else inode) number on its device
+    struct Place
+    {
+        enum Kind : quint8 { Physical, Inode, Unknown };
+        Kind kind{ Unknown };
+        quint64 device{ 0 };
+        quint64 position{ 0 };
+
+        auto operator<=>(const Place& other) const = default;
+    };
+    static Place placeOf(const QString& path);
+};
+
+}
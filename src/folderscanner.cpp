@@ -7,7 +7,14 @@
 //
 
 #include "folderscanner.hpp"
+#include "archivereader.hpp"
+#include "contentreader.hpp"
+#include "contentsniffer.hpp"
+#include "diskorder.hpp"
 #include "scanparams.hpp"
+#include "set_thread_name.hpp"
+#include <algorithm>
+#include <iterator>
 #include <mutex>
 #include <chrono>
 #include <thread>
@@ -19,6 +26,7 @@
 #include <QDir>
 #include <QFileInfo>
 #include <QQueue>
+#include <QStringDecoder>
 #include <QTimer>
 #include <QThread>
 #include <QDebug>
@@ -69,6 +77,7 @@ void FolderScanner::processEvents()
 
 void FolderScanner::stop() {
     stopped = true;
+    readBudget.wakeAll();  // the content readers waiting for memory
     emit scanCancelled();
 }
 
@@ -76,48 +85,85 @@ bool FolderScanner::isStopped() const {
     return stopped.load();
 }
 
-bool FolderScanner::appendOrExcludeItem(const QString& /*dirPath*/, const QFileInfo& info)
+FolderScanner::Verdict FolderScanner::checkEntry(const FsEntry& entry)
 {
-    const auto filePath = QDir::fromNativeSeparators(info.absoluteFilePath());
-    const auto isSymlink = isSymbolic(info);
-    const auto isDir = info.isDir() && !isSymlink;
-    const auto isFile = info.isFile() && !isSymlink;
-    if (!params.exclFolderPatterns.empty() &&
-            stringContainsAnyWord(filePath, params.exclFolderPatterns)) {
-        return false;
+    if (containsAny(exclFolderMatcher, entry.path)) {
+        return Verdict::Excluded;
     }
-    if (isFile) {
-        if (!params.exclFilePatterns.empty() &&
-                stringContainsAnyWord(info.fileName(), params.exclFilePatterns)) {
-            return false;
-        }
-        if (!params.exclusionWords.empty() &&
-                fileContainsAnyWordChunked(filePath, params.exclusionWords)) {
-            return false;
+    if (!entry.isFile()) {
+        auto toAppend = false;
+        if (params.searchWords.empty()) {
+            if (entry.isSymlink())
+                toAppend = params.inclSymlinks;
+            else if (entry.isDir())
+                toAppend = params.inclFolders;
         }
+        return toAppend ? Verdict::Found : Verdict::Excluded;
     }
-    auto toAppend = false;
-    if (params.searchWords.empty()) {
-        if (isSymlink)
-            toAppend = params.inclSymlinks;
-        else if (isDir)
-            toAppend = params.inclFolders;
+    if (!params.inclFiles || containsAny(exclFileMatcher, entry.name)) {
+        return Verdict::Excluded;
     }
-    if (isFile && params.inclFiles) {
-        toAppend = params.searchWords.empty() ||
-            fileContainsAllWordsChunked(filePath, params.searchWords);
+    if (params.searchWords.empty() && params.exclusionWords.empty()) {
+        return Verdict::Found;
     }
-    if (toAppend) {
-        if (isSymlink)
-            symlinkCount++;
-        else if (isDir)
-            dirCount++;
-        else if (isFile) {
-            foundCount++;
-            foundSize += (quint64)info.size();
-        }
+    return Verdict::ReadContents;
+}
+
+bool FolderScanner::checkContents(const FsEntry& entry)
+{
+    if (!matchCache && (!contentIndex || entry.member))
+        return searchContents(entry, FileKey());
+
+    // A member is as unchanged as its archive
+    const auto key = FileKey::of(entry.member ? entry.member->archivePath : entry.path);
+    if (matchCache) {
+        if (const auto cached = matchCache->lookup(entry.path, key, matchQuery))
+            return *cached;
+    }
+    const auto found = searchContents(entry, key);
+    // Not if cancelled: the file may not have been read to the words
+    if (matchCache && !stopped)
+        matchCache->store(entry.path, key, matchQuery, found);
+    return found;
+}
+
+bool FolderScanner::searchContents(const FsEntry& entry, const FileKey& key)
+{
+    // Exclusion and search words (or regex) in one read of the file
+    const auto* regex = params.regex ? &regexMatcher : nullptr;
+    if (!contentIndex || entry.member)
+        return fileMatchesWords(entry.path, contentMatcher, regex, entry.member.get());
+
+    // Answered by the content index if the file is unchanged since it was
+    // indexed; otherwise it is read to its end, and indexed.
+    switch (contentIndex->check(entry.path, key)) {
+    case ContentIndex::Answer::NoMatch:
+        return false;
+    case ContentIndex::Answer::Binary:
+        // As when read: a binary file that is skipped has no words
+        return contentMatcher.nbrSearchWords() == 0 && (!regex || regex->isEmpty());
+    case ContentIndex::Answer::Candidate:
+        return fileMatchesWords(entry.path, contentMatcher, regex);
+    case ContentIndex::Answer::Unknown:
+        break;
+    }
+    TrigramSet trigrams;
+    const auto found = fileMatchesWords(entry.path, contentMatcher, regex, nullptr, &trigrams);
+    if (!stopped)
+        contentIndex->store(entry.path, key, trigrams);
+    return found;
+}
+
+void FolderScanner::countFound(const FsEntry& entry, quint64 size)
+{
+    if (entry.isSymlink())
+        symlinkCount++;
+    else if (entry.isDir())
+        dirCount++;
+    else if (entry.isFile()) {
+        foundCount++;
+        foundSize += size;
     }
-    return toAppend;
 }
 
 void FolderScanner::zeroCounters()
@@ -125,33 +171,28 @@ void FolderScanner::zeroCounters()
     dirCount = 0;
     foundCount = 0;
     foundSize = 0;
+    symlinkCount = 0;
     totCount = 0;
     totSize = 0;
 }
 
-void FolderScanner::getAllDirs(const QString& dirPath, QFileInfoList& infos)
+void FolderScanner::resetLister(DirLister::StatFields fields, bool indexed)
 {
-    // Don't need files and not following symlinks
-    // QDir::AllDirs means "don't apply name filters to directories"
-    // Because we want to traverse the whole dir structure (except maybe hidden)
-    QDir dir(dirPath);
-    auto filters = QDir::Dirs | QDir::AllDirs | QDir::Drives | QDir::System | QDir::NoSymLinks | QDir::NoDotAndDotDot;
-    if (!params.exclHidden)
-        filters |= QDir::Hidden;
-    if (!stopped)
-        infos = dir.entryInfoList(filters);
+    // params may have changed since the previous operation
+    if (indexed && index) {
+        index->load();
+        index->resetStats();
+        lister = std::make_unique<IndexedDirLister>(params, *index);
+        return;
+    }
+    lister = DirLister::create(params, fields);
 }
 
-void FolderScanner::getFileInfos(const QString& dirPath, QFileInfoList& infos) /*const*/
+const DirLister& FolderScanner::dirLister()
 {
-    if (stopped)
-        return;
-    QDir dir(dirPath);
-    if (!params.nameFilters.empty()) {
-        dir.setNameFilters(params.nameFilters);
-    }
-    dir.setFilter(params.itemTypeFilter);
-    infos = dir.entryInfoList();
+    if (!lister)
+        resetLister();
+    return *lister;
 }
 
 quint64 FolderScanner::combinedSize(const QFileInfoList& infos)
@@ -166,131 +207,652 @@ quint64 FolderScanner::combinedSize(const QFileInfoList& infos)
     return size;
 }
 
-bool FolderScanner::stringContainsAllWords(const QString& str, const QStringList& words)
+void FolderScanner::compileMatchers()
 {
-    if (str.isEmpty() || words.empty())
-        return false;
-    for (const auto& word : words) {
-        if (stopped)
-            return false;
-        if (!str.contains(word, params.matchCase ? Qt::CaseSensitive : Qt::CaseInsensitive)) {
-            return false;
+    const auto toPatterns = [](const QStringList& words) {
+        std::vector<std::u16string> patterns;
+        patterns.reserve(size_t(words.size()));
+        for (const auto& word : words)
+            patterns.emplace_back(reinterpret_cast<const char16_t*>(word.utf16()), size_t(word.size()));
+        return patterns;
+    };
+    // Same folding as QString::contains(..., Qt::CaseInsensitive)
+    AhoCorasick<char16_t>::Fold fold = nullptr;
+    if (!params.matchCase) {
+        fold = [](char16_t c) { return char16_t(QChar::toCaseFolded(char32_t(c))); };
+    }
+    exclFolderMatcher = AhoCorasick<char16_t>(toPatterns(params.exclFolderPatterns), fold);
+    exclFileMatcher = AhoCorasick<char16_t>(toPatterns(params.exclFilePatterns), fold);
+    if (params.regex) {
+        contentMatcher = ContentMatcher({}, params.matchCase, params.exclusionWords, params.wholeWords);
+        regexMatcher = RegexMatcher(params.searchWords.join(QStringLiteral(" ")), params.matchCase, params.wholeWords);
+    }
+    else {
+        contentMatcher = ContentMatcher(params.searchWords, params.matchCase, params.exclusionWords, params.wholeWords);
+        regexMatcher = RegexMatcher();
+    }
+    if (params.searchArchives)
+        memberFilter = NameFilter(params.nameFilters, params.regex, params.wholeWords);
+
+    // The trigrams that a matching file must have: those of all the search
+    // words, or of one of the literals that every regex match contains.
+    // None for caseless non-ASCII words: Unicode case folding is not ASCII lower case.
+    contentQuery = {};
+    if (params.regex) {
+        for (const auto& literal : regexMatcher.literals())
+            contentQuery.groups.push_back(ContentIndex::trigramsOf(literal.data(), literal.size()));
+    }
+    else if (!contentMatcher.needsDecoding() && !params.searchWords.empty()) {
+        std::vector<quint32> all;
+        for (const auto& word : params.searchWords) {
+            const auto utf8 = word.toUtf8();
+            const auto trigrams = ContentIndex::trigramsOf(utf8.constData(), size_t(utf8.size()));
+            std::vector<quint32> merged;
+            std::set_union(all.begin(), all.end(), trigrams.begin(), trigrams.end(), std::back_inserter(merged));
+            all.swap(merged);
         }
+        contentQuery.groups.push_back(std::move(all));
     }
-    return true;
+
+    // Everything that changes which files match, in a canonical form:
+    // the order and duplicates of the words do not, nor their case if caseless.
+    const auto canonical = [this](const QStringList& words) {
+        QStringList sorted;
+        for (const auto& word : words)
+            sorted << (params.matchCase ? word : word.toCaseFolded());
+        sorted.sort();
+        sorted.removeDuplicates();
+        return sorted.join(QChar(0));
+    };
+    const auto flag = [](bool on) { return on ? QChar('1') : QChar('0'); };
+    auto query = QStringLiteral("v1 ") + flag(params.matchCase) + flag(params.wholeWords) + flag(params.regex)
+        + flag(params.inclBinaryFiles) + flag(params.decompress);
+    if (params.decompress)
+        query += QStringLiteral(" max ") + QString::number(params.maxDecompressedSize);
+    // A regex is the words joined in order
+    query += QStringLiteral("\nsearch ")
+        + (params.regex ? params.searchWords.join(QStringLiteral(" ")) : canonical(params.searchWords));
+    query += QStringLiteral("\nexclude ") + canonical(params.exclusionWords);
+    matchQuery = MatchCache::queryKey(query);
 }
 
-bool FolderScanner::stringContainsAnyWord(const QString& str, const QStringList& words)
+bool FolderScanner::containsAny(const AhoCorasick<char16_t>& matcher, const QString& str)
 {
-    if (str.isEmpty() || words.empty())
-        return false;
-    for (const auto& word : words) {
-        if (stopped)
-            return false;
-        if (str.contains(word, params.matchCase ? Qt::CaseSensitive : Qt::CaseInsensitive)) {
-            return true;
+    return !str.isEmpty() &&
+        matcher.containsAny(reinterpret_cast<const char16_t*>(str.utf16()), size_t(str.size()));
+}
+
+bool FolderScanner::fileMatchesWords(const QString& filePath, const ContentMatcher& matcher, const RegexMatcher* regex,
+                                     const ArchiveMember* member, TrigramSet* trigrams)
+{
+    if (regex && regex->isEmpty())
+        regex = nullptr;
+    // A file that is not read (empty, unreadable, binary) has no words
+    auto progress = matcher.start();
+    RegexMatcher::Progress regexProgress;
+    if ((matcher.isEmpty() && !regex) || QFileInfo(filePath).fileName() == ".DS_Store")
+        return matcher.matches(progress) && !regex;
+    if (matcher.needsDecoding())
+        return fileMatchesWordsDecoded(filePath, matcher, regex, member, trigrams);
+
+    // One pass over the UTF-8 bytes as they are in the file (mapped);
+    // the matcher states continue from one window to the next, so no overlap.
+    ContentReader reader(member ? member->archivePath : filePath, &readBudget);
+    reader.setCacheUse(params.spareCache, qint64(params.directReadMinSize));
+    reader.countHoles(&holeBytes);
+    reader.setCancel(&stopped);
+    if (params.decompress)
+        reader.setDecompression(params.maxDecompressedSize, &decompressionStats);
+    if (member)
+        ArchiveReader::openMember(reader, *member);
+    // A very big file (not to be indexed) is searched in parallel after its first window
+    const auto segmented = segmentedReads && !member && !regex && !trigrams && reader.size() >= SEGMENTED_MIN_SIZE;
+    const char* data = nullptr;
+    qint64 len = 0;
+    auto first = true;
+    auto wordsDone = matcher.isEmpty();
+    auto regexDone = !regex;
+    auto atEnd = false;
+    while (!stopped) {
+        if (!reader.next(data, len)) {
+            atEnd = true;
+            break;
         }
+        if (first && skipBinary(data, len)) {
+            if (trigrams)
+                trigrams->setBinary();
+            break;
+        }
+        const auto firstWindow = first;
+        first = false;
+        // To be indexed, the file is read to its end even when decided
+        if (trigrams)
+            trigrams->add(data, size_t(len));
+        if (!wordsDone && !progress.excluded)
+            wordsDone = matcher.feed(progress, data, size_t(len));
+        if (!regexDone && !progress.excluded)
+            regexDone = regex->feed(regexProgress, data, size_t(len));
+        if ((progress.excluded || (wordsDone && regexDone)) && !trigrams)
+            break;
+        if (firstWindow && segmented && !reader.isDecompressing()) {
+            // The segment readers lease their windows: not while this one holds its own
+            reader.releaseMemory();
+            return fileMatchesWordsSegmented(filePath, matcher, progress, len, reader.size());
+        }
+    }
+    // Not if cancelled or not readable: the rest of the file is not indexed
+    if (atEnd && trigrams && reader.atEnd())
+        trigrams->setComplete();
+    if (atEnd && !first && !progress.excluded) {
+        if (!wordsDone)
+            matcher.finish(progress);
+        if (regex)
+            regex->finish(regexProgress);
     }
-    return false;
+    return !stopped && matcher.matches(progress) && (!regex || regexProgress.found);
 }
 
-bool FolderScanner::fileContainsAllWordsChunked(const QString& filePath, const QStringList& words)
+bool FolderScanner::fileMatchesWordsSegmented(const QString& filePath, const ContentMatcher& matcher,
+                                              ContentMatcher::Progress& progress, qint64 from, qint64 size)
 {
-    QFile file(filePath);
-    if (file.size() == 0 || QFileInfo(file).fileName() == ".DS_Store")
-        return false;
-    if (!file.open(QIODevice::ReadOnly)) {
-        return false;
+    // The rest of the file (after @p from, the bytes fed to @p progress) is split
+    // into segments, searched by this reader and by the content readers that are
+    // idle meanwhile (no other threads): each one resumes the matcher state from
+    // the bytes before its segment, so a word may span two, and reads one byte
+    // past it, so that a whole word ending it is decided there.
+    // Their words are merged into @p progress as they are found, so all stop as
+    // soon as the result is known (an exclusion word, or all the search words).
+    auto job = std::make_shared<SegmentJob>();
+    job->filePath = filePath;
+    job->size = size;
+    job->matcher = &matcher;
+    job->progress = &progress;
+    // From the last byte fed: a whole word ending it was not decided
+    std::fill(progress.pending.begin(), progress.pending.end(), 0);
+    for (auto at = std::max<qint64>(from - 1, 0); at < size; at += SEGMENT_SIZE)
+        job->segments.push_back({ at, std::min(at + SEGMENT_SIZE, size) });
+    {
+        std::lock_guard<std::mutex> lock(segmentMutex);
+        segmentJobs.push_back(job);
+        segmentsQueued = true;
     }
-    static constexpr qint64 CHUNK_SIZE = 200 * 1024 * 1024;
-    while (!file.atEnd() && !stopped) {
-        const auto rsize = std::min(file.size() - file.pos(), CHUNK_SIZE);
-        const auto chunk = (rsize > 0) ? QString::fromUtf8(file.read(rsize)) : QString();
-        if (chunk.isEmpty()) {
-            return false;
+    searchSegments(*job);
+    // The helpers still searching use @p progress and @p matcher
+    std::unique_lock<std::mutex> lock(job->mutex);
+    job->closed = true;
+    job->idle.wait(lock, [&job]() { return job->active == 0; });
+    return !stopped && matcher.matches(progress);
+}
+
+bool FolderScanner::takeSegment(SegmentJob& job, SegmentJob::Segment& segment)
+{
+    std::lock_guard<std::mutex> lock(job.mutex);
+    const auto taken = !job.closed && !job.done && !stopped && job.next < job.segments.size();
+    if (taken) {
+        segment = job.segments[job.next++];
+        ++job.active;
+    }
+    if (!taken || job.next == job.segments.size()) {
+        // Nothing more for the idle readers
+        std::lock_guard<std::mutex> jobsLock(segmentMutex);
+        const auto it = std::find_if(segmentJobs.begin(), segmentJobs.end(),
+                                     [&job](const auto& queued) { return queued.get() == &job; });
+        if (it != segmentJobs.end())
+            segmentJobs.erase(it);
+        segmentsQueued = !segmentJobs.empty();
+    }
+    return taken;
+}
+
+void FolderScanner::searchSegments(SegmentJob& job)
+{
+    const auto& matcher = *job.matcher;
+    const auto context = qint64(matcher.maxWordLength());
+    const auto merge = [&job, &matcher](const ContentMatcher::Progress& part) {
+        std::lock_guard<std::mutex> lock(job.mutex);
+        if (matcher.merge(*job.progress, part))
+            job.done = true;
+    };
+    SegmentJob::Segment segment{};
+    while (takeSegment(job, segment)) {
+        const auto readBegin = std::max<qint64>(segment.begin - context, 0);
+        ContentReader reader(job.filePath, &readBudget);
+        reader.setCacheUse(params.spareCache, qint64(params.directReadMinSize));
+        reader.countHoles(&holeBytes);
+        reader.setCancel(&stopped);
+        reader.setRange(readBegin, std::min(segment.end + 1, job.size) - readBegin);
+        auto part = matcher.start();
+        auto skip = segment.begin - readBegin;
+        std::size_t nbrMerged = 0;
+        const char* data = nullptr;
+        qint64 len = 0;
+        auto atEnd = false;
+        auto decided = false;
+        while (!decided && !job.done && !stopped) {
+            if (!reader.next(data, len)) {
+                atEnd = true;
+                break;
+            }
+            if (skip > 0) {
+                const auto n = std::min(skip, len);
+                part = matcher.resume(data, size_t(n));
+                data += n;
+                len -= n;
+                skip = 0;
+            }
+            decided = matcher.feed(part, data, size_t(len));
+            if (part.excluded || part.nbrFound > nbrMerged) {
+                nbrMerged = part.nbrFound;
+                merge(part);
+            }
         }
-        if (!stringContainsAllWords(chunk, words)) {
-            return false;
+        // Whole words that end the file
+        if (atEnd && segment.end == job.size) {
+            matcher.finish(part);
+            merge(part);
         }
+        std::lock_guard<std::mutex> lock(job.mutex);
+        if (--job.active == 0)
+            job.idle.notify_all();
     }
+}
+
+bool FolderScanner::helpSegments()
+{
+    std::shared_ptr<SegmentJob> job;
+    {
+        std::lock_guard<std::mutex> lock(segmentMutex);
+        if (segmentJobs.empty())
+            return false;
+        job = segmentJobs.front();
+    }
+    searchSegments(*job);
     return true;
 }
 
-bool FolderScanner::fileContainsAnyWordChunked(const QString& filePath, const QStringList& words)
+bool FolderScanner::fileMatchesWordsDecoded(const QString& filePath, const ContentMatcher& matcher, const RegexMatcher* regex,
+                                            const ArchiveMember* member, TrigramSet* trigrams)
 {
-    QFile file(filePath);
-    if (file.size() == 0 || QFileInfo(file).fileName() == ".DS_Store")
-        return false;
-    if (!file.open(QIODevice::ReadOnly)) {
-        return false;
+    const auto& words = matcher.words();
+    qsizetype maxLen = 0;
+    for (const auto& word : words)
+        maxLen = std::max(maxLen, word.size());
+    // The decoder carries a character split between two windows, and the end
+    // of the previous window is kept to find a word split between two
+    // (and, for whole words, the character before it), so no overlap.
+    ContentReader reader(member ? member->archivePath : filePath, &readBudget);
+    reader.setCacheUse(params.spareCache, qint64(params.directReadMinSize));
+    reader.countHoles(&holeBytes);
+    reader.setCancel(&stopped);
+    if (params.decompress)
+        reader.setDecompression(params.maxDecompressedSize, &decompressionStats);
+    if (member)
+        ArchiveReader::openMember(reader, *member);
+    QStringDecoder toUtf16(QStringDecoder::Utf8);
+    const auto keep = maxLen + 1;
+    const auto nbrSearch = matcher.nbrSearchWords();
+    const auto decided = [&](std::size_t nbrFound) {
+        return nbrFound == nbrSearch && size_t(words.size()) == nbrSearch;
+    };
+    std::vector<bool> found(size_t(words.size()), false);
+    std::size_t nbrFound = 0;
+    // Returns false if an exclusion word is found
+    const auto findWords = [&](const QString& text, bool startsFile, bool endsFile) {
+        for (std::size_t i = 0; i < found.size(); ++i) {
+            if (found[i] || !matcher.containsWord(text, i, startsFile, endsFile))
+                continue;
+            if (matcher.isExclusionWord(i))
+                return false;
+            found[i] = true;
+            ++nbrFound;
+        }
+        return true;
+    };
+    RegexMatcher::Progress regexProgress;
+    QString text;  // the end of the previous window, then this one
+    const char* data = nullptr;
+    qint64 len = 0;
+    auto first = true;
+    auto cut = false;  // text no longer starts the file
+    auto atEnd = false;
+    auto excluded = false;
+    // To be indexed, the file is read to its end even when decided
+    const auto done = [&]() {
+        return excluded || (decided(nbrFound) && (!regex || regexProgress.found));
+    };
+    while (!stopped && (trigrams || !done())) {
+        if (!reader.next(data, len)) {
+            atEnd = true;
+            break;
+        }
+        if (first && skipBinary(data, len)) {
+            if (trigrams)
+                trigrams->setBinary();
+            return !regex && nbrSearch == 0;
+        }
+        first = false;
+        if (trigrams)
+            trigrams->add(data, size_t(len));
+        if (done())
+            continue;
+        if (regex && !regexProgress.found)
+            regex->feed(regexProgress, data, size_t(len));
+        text += toUtf16.decode(QByteArrayView(data, qsizetype(len)));
+        excluded = !findWords(text, !cut, false);
+        if (text.size() > keep) {
+            text = text.right(keep);
+            cut = true;
+        }
     }
-    static constexpr qint64 CHUNK_SIZE = 200 * 1024 * 1024;
-    while (!file.atEnd() && !stopped) {
-        const auto rsize = std::min(file.size() - file.pos(), CHUNK_SIZE);
-        const auto chunk = (rsize > 0) ? QString::fromUtf8(file.read(rsize)) : QString();
-        if (chunk.isEmpty()) {
+    // Not if cancelled or not readable: the rest of the file is not indexed
+    if (atEnd && trigrams && reader.atEnd())
+        trigrams->setComplete();
+    if (excluded)
+        return false;
+    if (atEnd && !first && !stopped) {
+        // Whole words at the very end of the file
+        if (matcher.matchesWholeWords() && !findWords(text, !cut, true))
             return false;
+        if (regex)
+            regex->finish(regexProgress);
+    }
+    return !stopped && nbrFound == nbrSearch && (!regex || regexProgress.found);
+}
+
+bool FolderScanner::skipBinary(const char* data, qint64 len) const
+{
+    // Sniffed in the first window of the file, which is read anyway
+    return !params.inclBinaryFiles && looksBinary(data, size_t(len));
+}
+
+void FolderScanner::setLastPath(const QString& path)
+{
+    // Only for progress reports, so don't make the workers wait for it
+    std::unique_lock<std::mutex> lock(lastPathMutex, std::try_to_lock);
+    if (lock.owns_lock())
+        sharedLastPath = path;
+}
+
+QString FolderScanner::getLastPath()
+{
+    std::lock_guard<std::mutex> lock(lastPathMutex);
+    return sharedLastPath;
+}
+
+void FolderScanner::scanDir(WorkStealingPool<DirTask>& pool, std::size_t worker, const DirTask& task, int maxDepth)
+{
+    const auto& [dirPath, currDepth] = task;
+    setLastPath(dirPath + QDir::separator());
+    if (stopped)
+        return;
+    DirListing listing;
+    lister->list(dirPath, listing);
+    for (const auto& dir : listing.subDirs) {
+        if (stopped) {
+            return;
+        }
+        if ((maxDepth < 0 || currDepth < maxDepth) && !containsAny(exclFolderMatcher, dir.path)) {
+                pool.push(worker, { dir.path, currDepth + 1 });
         }
-        if (stringContainsAnyWord(chunk, words)) {
-            return true;
+    }
+    // Not necessary: updateTotals(dirPath);
+
+    for (auto& entry : listing.candidates) {
+        if (stopped) {
+            return;
+        }
+        setLastPath(entry.path);
+        checkCandidate(entry);
+    }
+
+    // Archives are virtual folders one level down
+    for (const auto& archive : listing.archives) {
+        if (stopped) {
+            return;
+        }
+        if ((maxDepth < 0 || currDepth < maxDepth) && !containsAny(exclFileMatcher, archive.name)) {
+            setLastPath(archive.path);
+            scanArchive(archive);
         }
     }
-    return false;
 }
 
-void FolderScanner::deepScan(const QString& startPath, const int maxDepth)
+void FolderScanner::checkCandidate(FsEntry& entry)
 {
-    stopped = false;
-    zeroCounters();
-    QString lastPath;
-        
-    QQueue<QPair<QString, int>> dirQ;
-    dirQ.enqueue({ startPath, 0 });
-        
-    while (!dirQ.empty()) {
+    switch (checkEntry(entry)) {
+    case Verdict::Found:
+        queueFound(entry);
+        break;
+    case Verdict::ReadContents:
+        // Waits while the content readers are behind
+        contentQueue->push(std::move(entry), stopped);
+        break;
+    case Verdict::Excluded:
+        break;
+    }
+}
+
+void FolderScanner::scanArchive(const FsEntry& archive)
+{
+    // Only the archive's directory is read here: member contents are read
+    // (and inflated) by the content readers, and only if words are searched.
+    std::vector<ArchiveMember> members;
+    auto truncated = false;
+    if (!ArchiveReader::list(archive.path, members, &truncated))
+        return;
+    if (truncated) {
+        qDebug() << "Damaged or cut short archive, listed in part:" << archive.path;
+        ++truncatedArchives;
+    }
+    for (auto& member : members) {
         if (stopped) {
+            return;
+        }
+        const auto slash = member.name.lastIndexOf(u'/');
+        FsEntry entry;
+        entry.name = member.name.mid(slash + 1);
+        entry.hidden = entry.name.startsWith(u'.') || member.name.contains(QStringLiteral("/."));
+        if (entry.hidden && params.exclHidden)
+            continue;
+        entry.type = member.isDir ? FsEntry::Type::Dir : FsEntry::Type::File;
+        if ((entry.isDir() ? !params.inclFolders : !params.inclFiles) || !memberFilter.matches(entry.name))
+            continue;
+        entry.path = ArchiveReader::memberPath(archive.path, member.name);
+        entry.size = qint64(member.size);
+        entry.mtime = member.mtime;
+        entry.member = std::make_shared<const ArchiveMember>(std::move(member));
+        checkCandidate(entry);
+    }
+}
+
+void FolderScanner::readContents()
+{
+    auto& queue = orderedQueue ? *orderedQueue : *contentQueue;
+    while (!stopped) {
+        // The segments of a big file another reader is searching come first
+        if (segmentedReads && helpSegments())
+            continue;
+        auto entry = queue.pop(stopped, &segmentsQueued);
+        if (entry) {
+            if (checkContents(*entry))
+                queueFound(*entry);
+        }
+        else if (queue.ended()) {
             break;
         }
-        processEvents();
-        const auto [dirPath, currDepth] = dirQ.dequeue();
-        reportProgress(dirPath + QDir::separator());
-        QFileInfoList dirInfos;
-        getAllDirs(dirPath, dirInfos);
-        for (const auto& dir : dirInfos) {
-            lastPath = dirPath;
-            if (stopped) {
+    }
+}
+
+void FolderScanner::scheduleReads()
+{
+    // Takes what the walk queued, up to a batch, and passes it on in disk
+    // order; a smaller batch if the readers would wait, so they never do.
+    std::vector<FsEntry> batch;
+    const auto passOn = [this, &batch]() {
+        DiskOrder::sort(batch);
+        for (auto& entry : batch) {
+            if (!orderedQueue->push(std::move(entry), stopped))
                 break;
-            }
-            processEvents();
-            const auto dPath = dir.absoluteFilePath();
-            if ((maxDepth < 0 || currDepth < maxDepth) &&
-                (params.exclFolderPatterns.empty() || !stringContainsAnyWord(dPath, params.exclFolderPatterns))) {
-                    dirQ.enqueue({ dPath, currDepth + 1 });
-            }
-            reportProgress(dPath + QDir::separator());
         }
-        // Not necessary: updateTotals(dirPath);
-            
-        QFileInfoList infos;
-        getFileInfos(dirPath, infos);
-        for (const auto& info : infos) {
-            if (stopped) {
-                break;
-            }
-            processEvents();
-            const auto filePath = info.absoluteFilePath();
-            if (appendOrExcludeItem(filePath, info)) {
-                emit itemFound(filePath, info);
-            }
-            reportProgress(filePath);
-            lastPath = filePath;
+        batch.clear();
+    };
+    while (auto entry = contentQueue->pop(stopped)) {
+        batch.push_back(std::move(*entry));
+        contentQueue->popAll(batch);
+        if (batch.size() >= READ_BATCH_SIZE || orderedQueue->size() == 0)
+            passOn();
+    }
+    passOn();
+    orderedQueue->close();
+}
+
+void FolderScanner::queueFound(const FsEntry& entry)
+{
+    // Waits while the scanner thread is behind
+    if (entry.member) {
+        countFound(entry, entry.member->size);
+        foundQueue->push({ entry.path, QFileInfo(), entry.member }, stopped);
+        return;
+    }
+    // The GUI thread shows the item from what the QFileInfo has cached:
+    // the stat and the owner (and link target) lookups are done here
+    auto info = entry.fileInfo();
+    info.stat();
+    (void)info.owner();
+    if (isSymbolic(info))
+        (void)info.symLinkTarget();
+    // Not entry.size: that of the folder index may be out of date
+    countFound(entry, (quint64)info.size());
+    foundQueue->push({ entry.path, std::move(info), nullptr }, stopped);
+}
+
+void FolderScanner::emitFoundItems()
+{
+    std::vector<FoundItem> items;
+    foundQueue->popAll(items);
+    for (const auto& item : items) {
+        if (stopped)
+            return;
+        if (item.member)
+            emit memberFound(item.path, item.member->size, item.member->mtime, item.member->isDir);
+        else
+            emit itemFound(item.path, item.info);
+    }
+}
+
+void FolderScanner::deepScan(const QString& startPath, const int maxDepth)
+{
+    stopped = false;
+    zeroCounters();
+    compileMatchers();
+    resetLister(DirLister::StatNone, true);
+    setLastPath(startPath);
+
+    // Each worker scans one folder at a time and queues its sub-folders
+    // on its own deque; idle workers steal queued folders from the others.
+    // Files to search for words are queued to the content readers, so that
+    // reading a big file does not hold up the folder walk; found items
+    // are queued back to this thread, which emits them, processes events
+    // and reports progress.
+    WorkStealingPool<DirTask> pool(size_t(std::max(params.nbrScanThreads, 0)));
+    contentQueue = std::make_unique<BoundedQueue<FsEntry>>(CONTENT_QUEUE_SIZE);
+    foundQueue = std::make_unique<BoundedQueue<FoundItem>>(FOUND_QUEUE_SIZE);
+    readBudget.setLimit(size_t(params.readMemoryBudget));
+    decompressionStats.reset();
+    holeBytes = 0;
+    truncatedArchives = 0;
+    std::atomic<std::size_t> nbrReading{ 0 };
+    std::vector<std::jthread> readers;
+    const auto readsContents = !params.searchWords.empty() || !params.exclusionWords.empty();
+    // On a rotational disk, reading files in folder order is mostly seeking
+    const auto diskOrdered = readsContents && !params.unorderedReads &&
+        (params.diskOrderReads || DiskOrder::isRotational(startPath));
+    orderedQueue.reset();
+    segmentedReads = !diskOrdered;
+    if (readsContents) {
+        auto nbrReaders = params.nbrContentThreads > 0 ?
+            size_t(params.nbrContentThreads) : WorkStealingPool<DirTask>::defaultWorkerCount();
+        if (diskOrdered) {
+            orderedQueue = std::make_unique<BoundedQueue<FsEntry>>(CONTENT_QUEUE_SIZE);
+            if (params.nbrContentThreads <= 0)
+                nbrReaders = std::min(nbrReaders, DISK_ORDERED_READERS);
+            readers.emplace_back([this]() {
+                set_thread_name("ReadScheduler");
+                scheduleReads();
+            });
+        }
+        if (contentIndex) {
+            contentIndex->load();
+            contentIndex->prepare(contentQuery, params.decompress, params.maxDecompressedSize, params.inclBinaryFiles);
+        }
+        if (matchCache) {
+            matchCache->load();
+            matchCache->resetStats();
+        }
+        // Segments are searched by idle readers: with one, it would read them in turn
+        segmentedReads = segmentedReads && nbrReaders > 1;
+        nbrReading = nbrReaders;
+        for (std::size_t i = 0; i < nbrReaders; ++i) {
+            readers.emplace_back([this, &nbrReading]() {
+                set_thread_name("ContentReader");
+                readContents();
+                --nbrReading;
+            });
+        }
+    }
+    const auto poll = [this, &pool]() {
+        processEvents();
+        emitFoundItems();
+        if (progressTimer.elapsed() - prevProgress >= 500) {
+            emit queueDepths(pool.queued(), contentQueue->size() + (orderedQueue ? orderedQueue->size() : 0),
+                             foundQueue->size());
+            reportProgress(getLastPath(), true);
         }
+    };
+    pool.run({ DirTask{ startPath, 0 } },
+        [this, &pool, maxDepth](DirTask& task, std::size_t worker) {
+            scanDir(pool, worker, task, maxDepth);
+        },
+        stopped, poll);
+
+    // The walk is done: let the readers finish the queued files
+    contentQueue->close();
+    while (nbrReading > 0) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(50));
+        poll();
     }
+    readers.clear();
+    foundQueue->close();
+    emitFoundItems();
+    emit queueDepths(0, 0, 0);
+    if (decompressionStats.nbrFiles > 0 || decompressionStats.nbrOverLimit > 0) {
+        emit decompressed(decompressionStats.nbrFiles, decompressionStats.nbrBytes, decompressionStats.mbPerSecond(),
+                          decompressionStats.nbrOverLimit);
+    }
+    if (contentIndex && readsContents) {
+        emit contentIndexed(contentIndex->skippedFiles(), contentIndex->indexedFiles(), contentIndex->indexedBytes(),
+                            contentIndex->buildMbPerSecond(), contentIndex->queryMilliseconds());
+    }
+    if (matchCache && readsContents)
+        emit matchCacheUsed(matchCache->hits(), matchCache->lookups());
+    if (holeBytes > 0)
+        emit holesSkipped(holeBytes);
+    if (truncatedArchives > 0)
+        emit archivesTruncated(truncatedArchives);
+
     if (!stopped) {
-        reportProgress(lastPath, true);
+        reportProgress(getLastPath(), true);
         emit scanComplete();
     }
     stopped = true;
+    // Also after a cancel: every indexed folder is valid on its own
+    if (index && !index->save())
+        qDebug() << "Could not save the scan index" << index->fileName();
+    // Every file is indexed on its own too
+    if (contentIndex && readsContents && !contentIndex->save())
+        qDebug() << "Could not save the content index" << contentIndex->fileName();
+    if (matchCache && readsContents && !matchCache->save())
+        qDebug() << "Could not save the match cache" << matchCache->fileName();
 }
 
 uint64pair FolderScanner::deepCountSize(const QString& startPath)
@@ -301,41 +863,42 @@ uint64pair FolderScanner::deepCountSize(const QString& startPath)
     QQueue<QString> dirQ;
     dirQ.enqueue(startPath);
     zeroCounters();
+    // Not indexed: the index has the file sizes as of the last folder change
+    resetLister(DirLister::StatSize);
     QString lastPath;
+    DirListing listing;
 
     while (!dirQ.empty() && !stopped) {
         processEvents();
         const auto dirPath = dirQ.dequeue();
         lastPath = dirPath;
-        QFileInfoList dirInfos;
-        getAllDirs(dirPath, dirInfos);
-        for (const auto& info : dirInfos) {
+        lister->list(dirPath, listing);
+        for (const auto& dir : listing.subDirs) {
             //processEvents();
             if (stopped) {
                 emit scanCancelled();
                 return{ count, size };
             }
-            if (info.isDir() && !isSymbolic(info)) {
-                dirQ.enqueue(info.absoluteFilePath());
-            }
+            dirQ.enqueue(dir.path);
         }
 
-        QFileInfoList infos;
-        getFileInfos(dirPath, infos);
-        for (const auto& info : infos) {
+        for (const auto& entry : listing.candidates) {
             processEvents();
             if (stopped) {
                 emit scanCancelled();
                 return{ count, size };
             }
             ++count;
-            size += (quint64)info.size();
+            size += (quint64)entry.fileSize();
             foundCount = count;
             foundSize = size;
-            const auto filePath = info.absoluteFilePath();
-            reportProgress(filePath);
-            emit itemSized(filePath, info);
-            lastPath = filePath;
+            // A QFileInfo per file would cost another stat (native listers),
+            // so only the item shown in the progress label gets one.
+            if (progressTimer.elapsed() - prevProgress >= 500) {
+                emit itemSized(entry.path, entry.fileInfo());
+            }
+            reportProgress(entry.path);
+            lastPath = entry.path;
         }
     }
     if (!stopped) {
@@ -386,6 +949,7 @@ void FolderScanner::deepRemoveLimited(const IntQStringMap& rowPathMap, const int
 {
     stopped = false;
     zeroCounters();
+    resetLister();
     quint64 nbrDeleted = 0;
     IntQStringMap dirMap;
     auto res = true;
@@ -423,31 +987,31 @@ bool FolderScanner::deepRemLimitedImpl(const QString& startPath, const int maxDe
     dirQ.push({ startPath, 1 }); // start at level 1 here!
     auto res = true;
 
+    const auto& dirLst = dirLister();
+    DirListing listing;
+
     while (!dirQ.empty() && !stopped) {
         processEvents();
         const auto [dirPath, currDepth] = dirQ.front();
         dirQ.pop();
-        QFileInfoList dirInfos;
-        getAllDirs(dirPath, dirInfos);
-        for (const auto& dir : dirInfos) {
+        dirLst.list(dirPath, listing);
+        for (const auto& dir : listing.subDirs) {
             if (stopped) {
                 emit removalCancelled();
                 return res;
             }
             if (currDepth < maxDepth) {
-                dirQ.push({ dir.absoluteFilePath(), currDepth + 1 });
+                dirQ.push({ dir.path, currDepth + 1 });
             }
         }
-            
-        QFileInfoList infos;
-        getFileInfos(dirPath, infos);
-        for (const auto& info : infos) {
+
+        for (const auto& entry : listing.candidates) {
             processEvents();
             if (stopped) {
                 emit removalCancelled();
                 return res;
             }
-            if (!doRemoveOneFileOrDir(info, -1, nbrDeleted)) {  // Not in the files table, so row = -1
+            if (!doRemoveOneFileOrDir(entry.fileInfo(), -1, nbrDeleted)) {  // Not in the files table, so row = -1
                 res = false;
             }
         }
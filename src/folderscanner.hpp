@@ -7,12 +7,29 @@
 // WARRANTIES OF MERCHANTABILITY AND/OR FITNESS FOR A PARTICULAR PURPOSE.
 //
 
+#include "ahocorasick.hpp"
+#include "boundedqueue.hpp"
 #include "common.hpp"
+#include "contentindex.hpp"
+#include "contentmatcher.hpp"
+#include "decompressor.hpp"
+#include "dirlister.hpp"
+#include "matchcache.hpp"
+#include "memorybudget.hpp"
+#include "namefilter.hpp"
+#include "regexmatcher.hpp"
+#include "scanindex.hpp"
 #include "scanparams.hpp"
 #include "windows_symlink.hpp"
+#include "workstealingpool.hpp"
 #include <atomic>
+#include <condition_variable>
+#include <deque>
 #include <map>
+#include <memory>
+#include <mutex>
 #include <shared_mutex>
+#include <vector>
 #include <QDir>
 #include <QFileInfo>
 #include <QFileInfoList>
@@ -154,6 +171,10 @@ bool isSymbolic(const QFileInfo& info);
 /// It is used by the MainWindow class to perform folder scanning and file removal.
 /// It is a QObject, so it can be used with signals and slots.
 /// It is not thread-safe, so it should be used in a single thread.
+/// deepScan() itself is a pipeline: a WorkStealingPool of worker threads walks
+/// the folders, files whose contents must be searched are queued to a pool
+/// of content reader threads, and the found items are queued back to the
+/// calling thread, which emits them. It returns only when all are finished.
 /// It can be used with a QThread to perform scanning and removal in a separate thread.
 /// It can also be used with a jthread to perform scanning and removal in a separate thread
 /// @author Milivoj (Mike) DAVIDOV
@@ -164,13 +185,32 @@ public:
     explicit FolderScanner(QObject* parent=nullptr);
     bool isStopped() const;
     ScanParams params{};
+    std::shared_ptr<ScanIndex> index;  // optional, used by deepScan()
+    std::shared_ptr<ContentIndex> contentIndex;  // optional, used by deepScan() to search words
+    std::shared_ptr<MatchCache> matchCache;  // optional, used by deepScan() to search words
     quint64 combinedSize(const QFileInfoList& items);
 
 signals:
     void itemFound(const QString& path, const QFileInfo& info);
     void itemSized(const QString& path, const QFileInfo& info);
+    /// A found archive member ("archive!/name"), which has no QFileInfo
+    void memberFound(const QString& path, quint64 size, qint64 mtime, bool isDir);
     void itemRemoved(int row, quint64 count, quint64 size, quint64 nbrDeleted);
     void progressUpdate(const QString& path, quint64 totCount, quint64 totSize);
+    /// deepScan() pipeline stage backlogs: folders to walk, files to read, items to show
+    void queueDepths(quint64 dirsQueued, quint64 filesQueued, quint64 itemsQueued);
+    /// deepScan() compressed files searched: decompressed bytes, and MB/s of one reader thread;
+    /// and those not searched, as their decoder needs more memory than allowed
+    void decompressed(quint64 nbrFiles, quint64 nbrBytes, double mbPerSecond, quint64 nbrOverLimit);
+    /// deepScan() content index: files not read thanks to it, files (bytes) indexed and
+    /// MB/s of one reader thread, and the time to intersect the posting lists
+    void contentIndexed(quint64 nbrSkipped, quint64 nbrIndexed, quint64 nbrBytes, double mbPerSecond, double queryMs);
+    /// deepScan() match cache: files whose search result was cached, of those looked up
+    void matchCacheUsed(quint64 nbrHits, quint64 nbrLookups);
+    /// deepScan() sparse files: bytes of holes not read
+    void holesSkipped(quint64 nbrBytes);
+    /// deepScan() archives whose listing stopped at a damaged header (or cut short)
+    void archivesTruncated(quint64 nbrArchives);
     void scanComplete();
     void scanCancelled();
     void removalComplete(bool success);
@@ -188,16 +228,104 @@ public slots:
 
 public:
     void zeroCounters();
-    bool appendOrExcludeItem(const QString& dirPath, const QFileInfo& info);
-    void getAllDirs(const QString& path, QFileInfoList& infos);
-    void getFileInfos(const QString& path, QFileInfoList& infos) /*const*/;
-    bool stringContainsAllWords(const QString& str, const QStringList& words);
-    bool stringContainsAnyWord(const QString& str, const QStringList& words);
-    bool fileContainsAllWordsChunked(const QString& path, const QStringList& words);
-    bool fileContainsAnyWordChunked(const QString& path, const QStringList& words);
+    const DirLister& dirLister();
+    bool fileMatchesWords(const QString& path, const ContentMatcher& matcher, const RegexMatcher* regex = nullptr,
+                          const ArchiveMember* member = nullptr, TrigramSet* trigrams = nullptr);
+    bool fileMatchesWordsDecoded(const QString& path, const ContentMatcher& matcher, const RegexMatcher* regex,
+                                 const ArchiveMember* member, TrigramSet* trigrams);
+    bool skipBinary(const char* data, qint64 len) const;
+    bool fileMatchesWordsSegmented(const QString& path, const ContentMatcher& matcher,
+                                   ContentMatcher::Progress& progress, qint64 from, qint64 size);
 
 private:
+    /// A folder waiting to be scanned by deepScan() workers.
+    struct DirTask {
+        QString path;
+        int depth;
+    };
+    void scanDir(WorkStealingPool<DirTask>& pool, std::size_t worker, const DirTask& task, int maxDepth);
+    void scanArchive(const FsEntry& archive);
+    void checkCandidate(FsEntry& entry);
+
+    /// What checkEntry() decides about an entry without reading the file
+    enum class Verdict { Excluded, Found, ReadContents };
+    Verdict checkEntry(const FsEntry& entry);
+    bool checkContents(const FsEntry& entry);
+    bool searchContents(const FsEntry& entry, const FileKey& key);
+    /// Counts a found item; @p size of a file, as just stat'ed
+    void countFound(const FsEntry& entry, quint64 size);
+
+    /// deepScan() pipeline: files waiting for checkContents(),
+    /// found items waiting to be emitted (by emitFoundItems())
+    struct FoundItem {
+        QString path;
+        QFileInfo info;
+        std::shared_ptr<const ArchiveMember> member;  // instead of info
+    };
+    static constexpr std::size_t CONTENT_QUEUE_SIZE = 1024;
+    static constexpr std::size_t FOUND_QUEUE_SIZE = 4096;
+    static constexpr std::size_t READ_BATCH_SIZE = CONTENT_QUEUE_SIZE;  // files sorted in disk order at a time
+    static constexpr std::size_t DISK_ORDERED_READERS = 2;  // by default, so that they do not seek between files
+    static constexpr qint64 SEGMENTED_MIN_SIZE = qint64(256) * 1024 * 1024;  // files searched in parallel segments
+    static constexpr qint64 SEGMENT_SIZE = qint64(64) * 1024 * 1024;
+    bool segmentedReads{ true };  // not with diskOrdered reads: the segments would seek
+    /// A big file split into segments, searched by the content reader that
+    /// read its first window and by the readers that are idle meanwhile
+    struct SegmentJob {
+        struct Segment {
+            qint64 begin;
+            qint64 end;
+        };
+        QString filePath;
+        qint64 size{ 0 };
+        const ContentMatcher* matcher{ nullptr };
+        ContentMatcher::Progress* progress{ nullptr };  // merged into under mutex
+        std::vector<Segment> segments;
+        std::size_t next{ 0 };     // segments handed out
+        std::size_t active{ 0 };   // being searched
+        bool closed{ false };      // no more handed out
+        std::atomic<bool> done{ false };  // the result is known
+        std::mutex mutex;
+        std::condition_variable idle;  // active became 0
+    };
+    std::mutex segmentMutex;
+    std::deque<std::shared_ptr<SegmentJob>> segmentJobs;  // with segments to hand out
+    std::atomic<bool> segmentsQueued{ false };  // !segmentJobs.empty(): wakes the idle readers
+    bool takeSegment(SegmentJob& job, SegmentJob::Segment& segment);
+    void searchSegments(SegmentJob& job);
+    bool helpSegments();
+    std::unique_ptr<BoundedQueue<FsEntry>> contentQueue;
+    std::unique_ptr<BoundedQueue<FsEntry>> orderedQueue;  // contentQueue in disk order, if read so
+    std::unique_ptr<BoundedQueue<FoundItem>> foundQueue;
+    MemoryBudget readBudget;  // shared by the content readers
+    DecompressionStats decompressionStats;
+    std::atomic<std::uint64_t> holeBytes{ 0 };  // sparse file holes the content readers skipped
+    std::atomic<quint64> truncatedArchives{ 0 };  // listed in part
+    void readContents();
+    void scheduleReads();
+    void queueFound(const FsEntry& entry);
+    void emitFoundItems();
+    void resetLister(DirLister::StatFields fields = DirLister::StatNone, bool indexed = false);
+
+    /// Compiled once per scan from exclFolderPatterns / exclFilePatterns,
+    /// searchWords / exclusionWords (and matchCase, regex)
+    AhoCorasick<char16_t> exclFolderMatcher;
+    AhoCorasick<char16_t> exclFileMatcher;
+    ContentMatcher contentMatcher;
+    RegexMatcher regexMatcher;
+    NameFilter memberFilter;  // nameFilters, for archive members (not listed by the DirLister)
+    ContentIndex::Query contentQuery;  // the trigrams of searchWords
+    quint64 matchQuery{ 0 };  // MatchCache::queryKey() of the words and options
+    void compileMatchers();
+    static bool containsAny(const AhoCorasick<char16_t>& matcher, const QString& str);
+
     std::atomic<bool> stopped{ false };
+    std::unique_ptr<DirLister> lister;
+
+    QString sharedLastPath;
+    std::mutex lastPathMutex;
+    void setLastPath(const QString& path);
+    QString getLastPath();
 
     qint64 prevEvents{ 0 };
     QElapsedTimer eventsTimer;
@@ -207,12 +335,12 @@ private:
     QElapsedTimer progressTimer;
     void reportProgress(const QString& path, bool doit = false);
 
-    quint64 dirCount{0};
-    quint64 foundCount{0};
-    quint64 foundSize{0};
-    quint64 symlinkCount;
-    quint64 totCount{0};
-    quint64 totSize{0};
+    std::atomic<quint64> dirCount{0};
+    std::atomic<quint64> foundCount{0};
+    std::atomic<quint64> foundSize{0};
+    std::atomic<quint64> symlinkCount{0};
+    std::atomic<quint64> totCount{0};
+    std::atomic<quint64> totSize{0};
 };
 
 }
@@ -21,6 +21,7 @@
 #include "mainwindow.hpp"
 #include "scanparams.hpp"
 #include "aboutdialog.hpp"
+#include "archivereader.hpp"
 #include "helpdialog.hpp"
 #include "config.hpp"
 #include "util.hpp"
@@ -195,11 +196,14 @@ void MainWindow::createItemTypeCheckLayout()
     filesCheck->setChecked( true);
     foldersCheck->setChecked( true);
     symlinksCheck->setChecked( true);
+    archivesCheck = new QCheckBox(tr("&Archives"), this);
+    setAllTips(archivesCheck, eCod_SEARCH_ARCHIVES_TIP);
 
     itmTypeCheckLout = new QHBoxLayout(this);
     itmTypeCheckLout->addWidget( filesCheck);
     itmTypeCheckLout->addWidget( foldersCheck);
     itmTypeCheckLout->addWidget( symlinksCheck);
+    itmTypeCheckLout->addWidget( archivesCheck);
     itmTypeCheckLout->addSpacing(40);
     itmTypeCheckLout->addLayout( subDirDepthLout);
     itmTypeCheckLout->addStretch();
@@ -241,9 +245,25 @@ void MainWindow::createNavigLayout()
     matchCaseCheck = new QCheckBox(tr("&Match case"), this);
     setAllTips(matchCaseCheck, "Match or ignore the case of letters in search words. Does not affect file/folder names. ");
 
+    wholeWordsCheck = new QCheckBox(tr("&Whole words"), this);
+    setAllTips(wholeWordsCheck, eCod_WHOLE_WORDS_TIP);
+
+    regexCheck = new QCheckBox(tr("Rege&x"), this);
+    setAllTips(regexCheck, eCod_REGEX_TIP);
+
+    binaryCheck = new QCheckBox(tr("&Binary files"), this);
+    setAllTips(binaryCheck, eCod_SEARCH_BINARY_FILES_TIP);
+
+    compressedCheck = new QCheckBox(tr("&Compressed files"), this);
+    setAllTips(compressedCheck, eCod_SEARCH_COMPRESSED_TIP);
+
     wordsLout = new QHBoxLayout(this);
     wordsLout->addWidget(wordsLineEdit);
     wordsLout->addWidget(matchCaseCheck);
+    wordsLout->addWidget(wholeWordsCheck);
+    wordsLout->addWidget(regexCheck);
+    wordsLout->addWidget(binaryCheck);
+    wordsLout->addWidget(compressedCheck);
 
     namesLineEdit = new QLineEdit(this);
     namesLineEdit->setPlaceholderText("File/Folder names");
@@ -278,6 +298,24 @@ void MainWindow::createExclLayout()
     exclHiddenCheck->setText("Exclude hidden");
     setAllTips(exclHiddenCheck, eCod_EXCL_HIDDEN_ITEMS);
     modifyFont(exclHiddenCheck, +0.0, false, false, false);
+
+    useIndexCheck = new QCheckBox(this);
+    useIndexCheck->setChecked(Cfg::St().value(Cfg::useScanIndexKey, false).toBool());
+    useIndexCheck->setText("Remember folders");
+    setAllTips(useIndexCheck, eCod_USE_SCAN_INDEX_TIP);
+    modifyFont(useIndexCheck, +0.0, false, false, false);
+
+    contentIndexCheck = new QCheckBox(this);
+    contentIndexCheck->setChecked(Cfg::St().value(Cfg::useContentIndexKey, false).toBool());
+    contentIndexCheck->setText("Index contents");
+    setAllTips(contentIndexCheck, eCod_USE_CONTENT_INDEX_TIP);
+    modifyFont(contentIndexCheck, +0.0, false, false, false);
+
+    spareCacheCheck = new QCheckBox(this);
+    spareCacheCheck->setChecked(Cfg::St().value(Cfg::spareCacheKey, false).toBool());
+    spareCacheCheck->setText("Spare file cache");
+    setAllTips(spareCacheCheck, eCod_SPARE_CACHE_TIP);
+    modifyFont(spareCacheCheck, +0.0, false, false, false);
 }
 
 void MainWindow::createMainLayout()
@@ -331,6 +369,9 @@ void MainWindow::createMainLayout()
     mainLayout->addWidget(exclByFolderNameCombo,gridRowIdx, 0, 1, 3);
     ++gridRowIdx;
     mainLayout->addWidget(exclHiddenCheck,      gridRowIdx, 0);
+    mainLayout->addWidget(useIndexCheck,        gridRowIdx, 1);
+    mainLayout->addWidget(contentIndexCheck,    gridRowIdx, 2);
+    mainLayout->addWidget(spareCacheCheck,      gridRowIdx, 3);
     ++gridRowIdx;
     mainLayout->addWidget(filesTable,           gridRowIdx, 0, 1, 4);
     ++gridRowIdx;
@@ -367,6 +408,8 @@ void MainWindow::scopeCheckClicked(int /*newCheckState*/)
     const bool filesChecked = (filesCheck->checkState() == Qt::Checked);
     wordsLineEdit->setEnabled(filesChecked);
     matchCaseCheck->setEnabled(filesChecked);
+    binaryCheck->setEnabled(filesChecked);
+    compressedCheck->setEnabled(filesChecked);
     exclByFileNameCombo->setEnabled(filesChecked);
     exclFilesByTextCombo->setEnabled(filesChecked);
 }
@@ -402,6 +445,9 @@ void MainWindow::showMoreOptions(bool show)
     exclByFileNameCombo->setVisible(show);
     exclFilesByTextCombo->setVisible(show);
     exclHiddenCheck->setVisible(show);
+    useIndexCheck->setVisible(show);
+    contentIndexCheck->setVisible(show);
+    spareCacheCheck->setVisible(show);
 }
 
 void MainWindow::toggleExclClicked()
@@ -469,6 +515,9 @@ void MainWindow::getSelectedItems(IntQStringMap& itemList)
     for (const auto item : selectedItems) {
         if (_stopped)
             return;
+        // Archive members cannot be deleted or sized on their own
+        if (ArchiveReader::isMemberPath(item->data(Qt::UserRole).toString()))
+            continue;
         const auto info = QFileInfo(item->data(Qt::UserRole).toString());
         const auto path = QDir::toNativeSeparators(info.absoluteFilePath());
         const auto row = filesTable->row(item);
@@ -516,6 +565,12 @@ void MainWindow::Clear()
     _totCount = 0;
     _totSize = 0;
     _nbrDeleted = 0;
+    _queueDepths.clear();
+    _decompressed.clear();
+    _contentIndexed.clear();
+    _matchCacheUsed.clear();
+    _holesSkipped.clear();
+    _archivesTruncated.clear();
     processEvents();
 }
 
@@ -539,6 +594,7 @@ void MainWindow::setStopped(bool stopped)
     filesCheck->setEnabled(_stopped);
     foldersCheck->setEnabled(_stopped);
     symlinksCheck->setEnabled(_stopped);
+    archivesCheck->setEnabled(_stopped);
     unlimSubDirDepthBtn->setEnabled(_stopped);
     limSubDirDepthBtn->setEnabled(_stopped);
     maxSubDirDepthEdt->setEnabled(_stopped && limSubDirDepthBtn->isChecked());
@@ -547,10 +603,17 @@ void MainWindow::setStopped(bool stopped)
     browseButton->setEnabled(_stopped);
     wordsLineEdit->setEnabled( _stopped && filesCheck->isChecked());
     matchCaseCheck->setEnabled(_stopped && filesCheck->isChecked());
+    wholeWordsCheck->setEnabled(_stopped);
+    regexCheck->setEnabled(_stopped);
+    binaryCheck->setEnabled(_stopped && filesCheck->isChecked());
+    compressedCheck->setEnabled(_stopped && filesCheck->isChecked());
     exclByFolderNameCombo->setEnabled(_stopped);
     exclByFileNameCombo->setEnabled(_stopped);
     exclFilesByTextCombo->setEnabled(_stopped);
     exclHiddenCheck->setEnabled(_stopped);
+    useIndexCheck->setEnabled(_stopped);
+    contentIndexCheck->setEnabled(_stopped);
+    spareCacheCheck->setEnabled(_stopped);
     filesTable->horizontalHeader()->setEnabled( _stopped);
     filesTable->verticalHeader()->setEnabled(_stopped);
 }
@@ -604,6 +667,11 @@ void MainWindow::setFilesFoundLabel(const QString& prefix, bool appendCounts /*=
                                 .arg(elapsedStr);
                                 //.arg(_totCount)
                                 //.arg(totItemsSizeStr);
+        foundLabelText += _decompressed;
+        foundLabelText += _contentIndexed;
+        foundLabelText += _matchCacheUsed;
+        foundLabelText += _holesSkipped;
+        foundLabelText += _archivesTruncated;
     }
     filesFoundLabel->setText(foundLabelText);
     if ((_foundCount + _dirCount + _symlinkCount) != quint64(filesTable->rowCount())) {
@@ -631,11 +699,67 @@ void MainWindow::setParamsFromUi() // before starting search
     scanner->params.inclFolders = foldersCheck->isChecked();
     scanner->params.inclSymlinks = symlinksCheck->isChecked();
     scanner->params.exclHidden = exclHiddenCheck->isChecked();
+    // Settings only, 0 (the default): one folder walker per CPU core
+    scanner->params.nbrScanThreads = Cfg::St().value(Cfg::scanThreadsKey, 0).toInt();
+    // Settings only: the portable listing, e.g. to compare with the native one
+    scanner->params.qtDirListing = Cfg::St().value(Cfg::qtDirListingKey, false).toBool();
+    // Settings only: force batched statx on or off, else automatic on network file systems
+    scanner->params.uringStat = Cfg::St().value(Cfg::uringStatKey, false).toBool();
+    scanner->params.syncStat = Cfg::St().value(Cfg::syncStatKey, false).toBool();
+
+    Cfg::St().setValue(Cfg::useScanIndexKey, useIndexCheck->isChecked());
+    if (useIndexCheck->isChecked()) {
+        if (!scanIndex) {
+            scanIndex = std::make_shared<ScanIndex>(ScanIndex::defaultFilePath());
+            // Keeps the index current between searches (where supported)
+            scanIndex->setDirWatcher(DirWatcher::create());
+        }
+        scanner->index = scanIndex;
+    }
+    Cfg::St().setValue(Cfg::useContentIndexKey, contentIndexCheck->isChecked());
+    if (contentIndexCheck->isChecked()) {
+        if (!contentIndex)
+            contentIndex = std::make_shared<ContentIndex>(ContentIndex::defaultFilePath());
+        scanner->contentIndex = contentIndex;
+    }
+    Cfg::St().setValue(Cfg::spareCacheKey, spareCacheCheck->isChecked());
+    scanner->params.spareCache = spareCacheCheck->isChecked();
+    scanner->params.directReadMinSize = spareCacheCheck->isChecked() ?
+        Cfg::St().value(Cfg::directReadMinSizeKey, 0).toULongLong() * 1024 * 1024 : 0;
+    // Settings only, 0 (the default): one per CPU core, or 2 on a rotational disk
+    scanner->params.nbrContentThreads = Cfg::St().value(Cfg::contentThreadsKey, 0).toInt();
+    // MB of file windows held by all the readers, 0 (the default): MemoryBudget::DEFAULT_LIMIT
+    scanner->params.readMemoryBudget = Cfg::St().value(Cfg::readMemoryBudgetKey, 0).toULongLong() * 1024 * 1024;
+    // Settings only: force disk order reads on or off, else automatic on rotational disks
+    scanner->params.diskOrderReads = Cfg::St().value(Cfg::diskOrderReadsKey, false).toBool();
+    scanner->params.unorderedReads = Cfg::St().value(Cfg::unorderedReadsKey, false).toBool();
+    // Only if asked for: in memory for the session if indexing contents,
+    // on disk too if remembering folders
+    if (useIndexCheck->isChecked() || contentIndexCheck->isChecked()) {
+        if (!matchCache)
+            matchCache = std::make_shared<MatchCache>(MatchCache::defaultFilePath());
+        matchCache->setPersistent(useIndexCheck->isChecked());
+        scanner->matchCache = matchCache;
+    }
+    else {
+        matchCache.reset();
+    }
 
     _matchCase = matchCaseCheck->isChecked();
     scanner->params.matchCase = _matchCase;
-
-    _searchWords        = wordsLineEdit->text().split(" ", Qt::SkipEmptyParts);
+    scanner->params.inclBinaryFiles = binaryCheck->isChecked();
+    scanner->params.decompress = compressedCheck->isChecked();
+    scanner->params.maxDecompressedSize =
+        Cfg::St().value(Cfg::maxDecompressedSizeKey, 0).toULongLong() * 1024 * 1024;
+    scanner->params.searchArchives = archivesCheck->isChecked();
+    scanner->params.regex = regexCheck->isChecked();
+    scanner->params.wholeWords = wholeWordsCheck->isChecked();
+
+    // A regular expression may have spaces: not split into words
+    const auto wordsText = wordsLineEdit->text().trimmed();
+    _searchWords = scanner->params.regex ?
+        (wordsText.isEmpty() ? QStringList() : QStringList{ wordsText }) :
+        wordsText.split(" ", Qt::SkipEmptyParts);
     _exclusionWords     = exclFilesByTextCombo->text().split(" ", Qt::SkipEmptyParts);
     _exclFilePatterns   = exclByFileNameCombo->text().split(" ", Qt::SkipEmptyParts);
     _exclFolderPatterns = exclByFolderNameCombo->text().split(" ", Qt::SkipEmptyParts);
@@ -645,7 +769,9 @@ void MainWindow::setParamsFromUi() // before starting search
     scanner->params.exclFolderPatterns = _exclFolderPatterns;
 
     _fileNameFilter = namesLineEdit->text().trimmed();
-    scanner->params.nameFilters = _fileNameFilter.split(" ", Qt::SkipEmptyParts);
+    scanner->params.nameFilters = scanner->params.regex ?
+        (_fileNameFilter.isEmpty() ? QStringList() : QStringList{ _fileNameFilter }) :
+        _fileNameFilter.split(" ", Qt::SkipEmptyParts);
 
     BATCH_SIZE = (_searchWords.isEmpty() &&
                   _exclusionWords.isEmpty() &&
@@ -690,6 +816,25 @@ bool MainWindow::findFilesPrep()
         setStopped(true);
         return false;
     }
+    if (scanner->params.regex) {
+        // Check both regular expressions before searching
+        QString error;
+        for (const auto& pattern : scanner->params.searchWords + scanner->params.nameFilters) {
+            const QRegularExpression regex(pattern);
+            if (!regex.isValid()) {
+                error = tr("Invalid regular expression \"%1\": %2").arg(pattern).arg(regex.errorString());
+                break;
+            }
+        }
+        if (!error.isEmpty()) {
+            setFilesFoundLabel(error, false);
+            #if !defined(Q_OS_MAC)
+                QMessageBox::warning(this, OvSk_FsOp_APP_NAME_TXT, error);
+            #endif
+            setStopped(true);
+            return false;
+        }
+    }
     _origDirPath = QDir::toNativeSeparators(dirComboCurrent);
     if (_origDirPath.startsWith("~")) {
         _origDirPath = (_origDirPath.length() > 1) ?
@@ -919,8 +1064,25 @@ void MainWindow::appendItemToTable(const QString& filePath, const QFileInfo& fin
     const auto isSymlink = isSymbolic(finfo);
     const auto isDir = finfo.isDir() && !isSymlink;
     const auto isFile = finfo.isFile() && !isSymlink;
-    const auto isHidden = finfo.isHidden();
-    const auto fsize = (quint64)finfo.size();
+    appendRowToTable(filePath, finfo, isFile, isDir, isSymlink, finfo.isHidden(),
+                     (quint64)finfo.size(), finfo.lastModified(), finfo.owner());
+}
+
+void MainWindow::appendMemberToTable(const QString& filePath, quint64 size, qint64 mtime, bool isDir)
+{
+    if (_stopped)
+        return;
+    // Not on disk: the QFileInfo is only used for the path strings
+    const QFileInfo finfo(filePath);
+    const auto isHidden = finfo.fileName().startsWith('.');
+    const auto modified = mtime >= 0 ? QDateTime::fromMSecsSinceEpoch(mtime) : QDateTime();
+    appendRowToTable(filePath, finfo, !isDir, isDir, false, isHidden, isDir ? 0 : size, modified, QString());
+}
+
+void MainWindow::appendRowToTable(const QString& filePath, const QFileInfo& finfo, bool isFile, bool isDir,
+                                  bool isSymlink, bool isHidden, quint64 fsize, const QDateTime& modified,
+                                  const QString& owner)
+{
     if (isSymlink)
         _symlinkCount++;
     else if (isDir)
@@ -967,7 +1129,7 @@ void MainWindow::appendItemToTable(const QString& filePath, const QFileInfo& fin
     QTableWidgetItem * dateModItem = new QTableWidgetItem();
     dateModItem->setTextAlignment( Qt::AlignHCenter | Qt::AlignVCenter);
     dateModItem->setFlags( dateModItem->flags() ^ Qt::ItemIsEditable);
-    dateModItem->setData( Qt::DisplayRole, finfo.lastModified());
+    dateModItem->setData( Qt::DisplayRole, modified);
 
     const double sizeKB = fsize > 0 && fsize < 104 ?
                             0.1 : double(fsize) / double(1024);
@@ -984,7 +1146,7 @@ void MainWindow::appendItemToTable(const QString& filePath, const QFileInfo& fin
     fsTypeItem->setFlags(fsTypeItem->flags() ^ Qt::ItemIsEditable);
     fsTypeItem->setTextAlignment(Qt::AlignHCenter | Qt::AlignVCenter);
 
-    auto ownerItem = new QTableWidgetItem(finfo.owner());
+    auto ownerItem = new QTableWidgetItem(owner);
     ownerItem->setFlags(ownerItem->flags() ^ Qt::ItemIsEditable);
     ownerItem->setTextAlignment(Qt::AlignHCenter | Qt::AlignVCenter);
     ownerItem->setData(Qt::ToolTipRole, QVariant("Username of the item's owner."));
@@ -1192,7 +1354,7 @@ void MainWindow::openRunSlot() {
         return;
     }
     const auto item = selectedItems.first();
-    const auto finfo = QFileInfo(item->data(Qt::UserRole).toString());
+    const auto finfo = QFileInfo(ArchiveReader::diskPath(item->data(Qt::UserRole).toString()));
     // absoluteFilePath() is good for both files and folders
     const auto url = QUrl::fromLocalFile(finfo.absoluteFilePath());
     QDesktopServices::openUrl(url);
@@ -1204,7 +1366,7 @@ void MainWindow::openContainingFolderSlot() {
         return;
     }
     const auto item = selectedItems.first();
-    const auto finfo = QFileInfo(item->data(Qt::UserRole).toString());
+    const auto finfo = QFileInfo(ArchiveReader::diskPath(item->data(Qt::UserRole).toString()));
     // absolutePath() is the containing folder (i.e. absolute path
     // without the file/folder name)
     const auto url = QUrl::fromLocalFile(finfo.absolutePath());
@@ -1276,7 +1438,7 @@ void MainWindow::propertiesSlot() {
         return;
     }
     const auto item = selectedItems.first();
-    const auto finfo = QFileInfo(item->data(Qt::UserRole).toString());
+    const auto finfo = QFileInfo(ArchiveReader::diskPath(item->data(Qt::UserRole).toString()));
     const auto filePath = QDir::toNativeSeparators(finfo.absoluteFilePath());
 #if defined(Q_OS_LINUX)
     QProcess::startDetached("xdg-open", QStringList() << filePath);
@@ -1345,9 +1507,16 @@ void MainWindow::deepScanFolderOnThread(const QString& startPath, const int maxD
     connect(scanThread.get(), &QThread::finished, this, &MainWindow::scanThreadFinished);
 
     connect(scanner.get(), &FolderScanner::itemFound, this, &MainWindow::itemFound);
+    connect(scanner.get(), &FolderScanner::memberFound, this, &MainWindow::memberFound);
     connect(scanner.get(), &FolderScanner::itemSized, this, &MainWindow::itemSized);
     connect(scanner.get(), &FolderScanner::itemRemoved, this, &MainWindow::itemRemoved);
     connect(scanner.get(), &FolderScanner::progressUpdate, this, &MainWindow::progressUpdate);
+    connect(scanner.get(), &FolderScanner::queueDepths, this, &MainWindow::queueDepths);
+    connect(scanner.get(), &FolderScanner::decompressed, this, &MainWindow::decompressed);
+    connect(scanner.get(), &FolderScanner::contentIndexed, this, &MainWindow::contentIndexed);
+    connect(scanner.get(), &FolderScanner::matchCacheUsed, this, &MainWindow::matchCacheUsed);
+    connect(scanner.get(), &FolderScanner::holesSkipped, this, &MainWindow::holesSkipped);
+    connect(scanner.get(), &FolderScanner::archivesTruncated, this, &MainWindow::archivesTruncated);
 
     connect(scanner.get(), &FolderScanner::scanComplete, scanThread.get(), &QThread::quit);
     connect(scanner.get(), &FolderScanner::scanCancelled, scanThread.get(), &QThread::quit);
@@ -1435,6 +1604,11 @@ void MainWindow::itemFound(const QString& path, const QFileInfo& info) {
         appendItemToTable(path, info);
 }
 
+void MainWindow::memberFound(const QString& path, quint64 size, qint64 mtime, bool isDir) {
+    if (!_stopped)
+        appendMemberToTable(path, size, mtime, isDir);
+}
+
 void MainWindow::itemSized(const QString& path, const QFileInfo& info) {
     if (!_stopped)
         filesFoundLabel->setText(path + " " + sizeToHumanReadable((quint64)info.size()));
@@ -1454,15 +1628,71 @@ void MainWindow::progressUpdate(const QString& path, quint64 totCount, quint64 t
     _totCount = totCount;
     _totSize = totSize;
     if (!_stopped && !_gettingSize) {
-        filesFoundLabel->setText(QString("%1 matching files, %2 folders, %3 %4...  Searching through %5")
+        filesFoundLabel->setText(QString("%1 matching files, %2 folders, %3 %4...%5  Searching through %6")
             .arg(_foundCount)
             .arg(_dirCount)
             .arg(_symlinkCount)
             .arg(OvSk_FsOp_SYMLINKS_TXT)
+            .arg(_queueDepths)
             .arg(QDir::toNativeSeparators(path)));
     }
 }
 
+void MainWindow::queueDepths(quint64 dirsQueued, quint64 filesQueued, quint64 itemsQueued)
+{
+    // The fullest queue is the one in front of the slowest stage
+    if (dirsQueued + filesQueued + itemsQueued == 0)
+        _queueDepths.clear();
+    else
+        _queueDepths = QString("  Queued: %1 folders, %2 files to read, %3 items to show.")
+            .arg(dirsQueued)
+            .arg(filesQueued)
+            .arg(itemsQueued);
+}
+
+void MainWindow::decompressed(quint64 nbrFiles, quint64 nbrBytes, double mbPerSecond, quint64 nbrOverLimit)
+{
+    _decompressed = QString("; decompressed %1 files (%2) at %3 MB/s per core")
+        .arg(nbrFiles)
+        .arg(sizeToHumanReadable(nbrBytes))
+        .arg(mbPerSecond, 0, 'f', 0);
+    if (nbrOverLimit > 0)
+        _decompressed += QString(", %1 not searched (over the memory limit)").arg(nbrOverLimit);
+}
+
+void MainWindow::contentIndexed(quint64 nbrSkipped, quint64 nbrIndexed, quint64 nbrBytes, double mbPerSecond, double queryMs)
+{
+    _contentIndexed = QString("; index: %1 files not read (query %2 ms)")
+        .arg(nbrSkipped)
+        .arg(queryMs, 0, 'f', 1);
+    if (nbrIndexed > 0) {
+        _contentIndexed += QString(", %1 files (%2) indexed at %3 MB/s per core")
+            .arg(nbrIndexed)
+            .arg(sizeToHumanReadable(nbrBytes))
+            .arg(mbPerSecond, 0, 'f', 0);
+    }
+}
+
+void MainWindow::matchCacheUsed(quint64 nbrHits, quint64 nbrLookups)
+{
+    if (nbrLookups == 0)
+        return;
+    _matchCacheUsed = QString("; match cache: %1 of %2 files (%3%)")
+        .arg(nbrHits)
+        .arg(nbrLookups)
+        .arg(100.0 * double(nbrHits) / double(nbrLookups), 0, 'f', 0);
+}
+
+void MainWindow::holesSkipped(quint64 nbrBytes)
+{
+    _holesSkipped = QString("; skipped %1 of sparse file holes").arg(sizeToHumanReadable(nbrBytes));
+}
+
+void MainWindow::archivesTruncated(quint64 nbrArchives)
+{
+    _archivesTruncated = QString("; %1 damaged archives listed in part").arg(nbrArchives);
+}
+
 void MainWindow::removeRows()
 {
     {
@@ -101,9 +101,16 @@ public:
 
 public slots:
     void itemFound(const QString& path, const QFileInfo& info);
+    void memberFound(const QString& path, quint64 size, qint64 mtime, bool isDir);
     void itemSized(const QString& path, const QFileInfo& info);
     void itemRemoved(int row, quint64 count, quint64 size, quint64 nbrDeleted);
     void progressUpdate(const QString& path, quint64 totCount, quint64 totSize);
+    void queueDepths(quint64 dirsQueued, quint64 filesQueued, quint64 itemsQueued);
+    void decompressed(quint64 nbrFiles, quint64 nbrBytes, double mbPerSecond, quint64 nbrOverLimit);
+    void contentIndexed(quint64 nbrSkipped, quint64 nbrIndexed, quint64 nbrBytes, double mbPerSecond, double queryMs);
+    void matchCacheUsed(quint64 nbrHits, quint64 nbrLookups);
+    void holesSkipped(quint64 nbrBytes);
+    void archivesTruncated(quint64 nbrArchives);
     void removalComplete(bool success);
     void stopRemoverThreads();
 
@@ -140,6 +147,9 @@ private slots:
 private:
     std::shared_ptr<QThread> scanThread;
     std::shared_ptr<FolderScanner> scanner;
+    std::shared_ptr<ScanIndex> scanIndex;  // created when first used, shared by the scanners
+    std::shared_ptr<ContentIndex> contentIndex;  // ditto
+    std::shared_ptr<MatchCache> matchCache;  // ditto, if either index is used
     std::shared_ptr<Frv2::FileRemover> removerFrv2;
     std::shared_ptr<Frv3::FileRemover> removerFrv3;
 
@@ -167,6 +177,10 @@ private:
     QComboBox* createComboBoxText(QWidget* parent);
     void createFilesTable();
     void appendItemToTable(const QString& filePath, const QFileInfo & finfo);
+    void appendMemberToTable(const QString& filePath, quint64 size, qint64 mtime, bool isDir);
+    void appendRowToTable(const QString& filePath, const QFileInfo& finfo, bool isFile, bool isDir,
+                          bool isSymlink, bool isHidden, quint64 fsize, const QDateTime& modified,
+                          const QString& owner);
 
     void deepScanFolderOnThread(const QString& startPath, const int maxDepth);
     void scanThreadFinished();
@@ -211,7 +225,12 @@ private:
     QCheckBox*  filesCheck;
     QCheckBox*  foldersCheck;
     QCheckBox*  symlinksCheck;
+    QCheckBox*  archivesCheck;
     QCheckBox*  matchCaseCheck;
+    QCheckBox*  wholeWordsCheck;
+    QCheckBox*  regexCheck;
+    QCheckBox*  binaryCheck;
+    QCheckBox*  compressedCheck;
     QHBoxLayout*itmTypeCheckLout;
     QHBoxLayout*wordsLout;
 
@@ -227,6 +246,9 @@ private:
     QLineEdit* exclByFolderNameCombo;
     QLineEdit* exclFilesByTextCombo;
     QCheckBox* exclHiddenCheck;
+    QCheckBox* useIndexCheck;
+    QCheckBox* contentIndexCheck;
+    QCheckBox* spareCacheCheck;
 
     QToolButton* browseButton;
     QToolButton* goUpButton;
@@ -274,6 +296,12 @@ private:
     quint64 _totCount;
     quint64 _totSize;
     quint64 _nbrDeleted;
+    QString _queueDepths;  // deepScan() pipeline backlogs, empty when none
+    QString _decompressed;  // compressed files searched, empty when none
+    QString _contentIndexed;  // content index statistics, empty when not used
+    QString _matchCacheUsed;  // match cache hit rate, empty when no file was looked up
+    QString _holesSkipped;  // sparse file holes not read, empty when none
+    QString _archivesTruncated;  // archives listed in part, empty when none
 
     mmd::FsOpType _opType;
     bool _stopped{ true };
@@ -0,0 +1,198 @@
+//
+// Copyright (c) Milivoj (Mike) DAVIDOV
+//
+// THIS SOFTWARE IS PROVIDED "AS IS" WITHOUT WARRANTY OF ANY KIND,
+// EITHER EXPRESSED OR IMPLIED, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+// WARRANTIES OF MERCHANTABILITY AND/OR FITNESS FOR A PARTICULAR PURPOSE.
+//
+
+#include "matchcache.hpp"
+#include "scanindex.hpp"
+#include <algorithm>
+#include <QByteArray>
+#include <QDataStream>
+#include <QDateTime>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QSaveFile>
+#include <QDebug>
+
+namespace mmd
+{
+namespace
+{
+constexpr quint32 CACHE_MAGIC = 0x4D534D43;  // "MSMC"
+constexpr quint32 CACHE_VERSION = 2;
+
+// As for folders (see ScanIndex): a file read within that long of its
+// last change may change again without a new mtime, so it is not trusted.
+constexpr qint64 MTIME_RESOLUTION_MS = 2000;
+}
+
+MatchCache::MatchCache(const QString& cacheFilePath)
+    : filePath(cacheFilePath)
+{
+}
+
+QString MatchCache::defaultFilePath()
+{
+    return QFileInfo(ScanIndex::defaultFilePath()).absolutePath() + QStringLiteral("/matchcache.bin");
+}
+
+quint64 MatchCache::queryKey(const QString& normalizedQuery)
+{
+    // Not qHash(), which is seeded per process
+    quint64 hash = 14695981039346656037ull;
+    for (const auto c : normalizedQuery.toUtf8()) {
+        hash ^= static_cast<unsigned char>(c);
+        hash *= 1099511628211ull;
+    }
+    return hash;
+}
+
+void MatchCache::load()
+{
+    std::lock_guard<std::mutex> fileLock(fileMutex);
+    if (loaded || !persistent)
+        return;
+    loaded = true;
+    QFile file(filePath);
+    if (!file.open(QIODevice::ReadOnly))
+        return;
+    QDataStream in(&file);
+    in.setVersion(QDataStream::Qt_6_0);
+    quint32 magic = 0;
+    quint32 version = 0;
+    quint64 nbrFiles = 0;
+    in >> magic >> version >> nbrFiles;
+    if (magic != CACHE_MAGIC || version != CACHE_VERSION)
+        return;
+
+    std::map<QString, FileRecord> loadedFiles;
+    for (quint64 f = 0; f < nbrFiles && in.status() == QDataStream::Ok; ++f) {
+        QString path;
+        FileRecord rec;
+        quint8 nbrResults = 0;
+        in >> path >> rec.key.device >> rec.key.inode >> rec.key.size >> rec.key.mtime >> rec.lastUsed >> nbrResults;
+        if (nbrResults > MAX_QUERIES_PER_FILE) {
+            in.setStatus(QDataStream::ReadCorruptData);
+            break;
+        }
+        rec.results.resize(nbrResults);
+        for (auto& r : rec.results)
+            in >> r.query >> r.cachedAt >> r.matches;
+        loadedFiles.emplace_hint(loadedFiles.end(), std::move(path), std::move(rec));
+    }
+    if (in.status() != QDataStream::Ok) {
+        qDebug() << "Ignoring corrupt match cache" << filePath;
+        return;
+    }
+    std::unique_lock<std::shared_mutex> lock(mutex);
+    // Files cached before loading finished are newer, so they are kept
+    quint64 lastUsed = 0;
+    for (const auto& [path, rec] : loadedFiles)
+        lastUsed = std::max(lastUsed, rec.lastUsed);
+    for (auto& [path, rec] : files)
+        rec.lastUsed += lastUsed;
+    useClock += lastUsed;
+    files.merge(loadedFiles);
+    if (files.size() > MAX_FILES)
+        evict();
+}
+
+bool MatchCache::save()
+{
+    std::lock_guard<std::mutex> fileLock(fileMutex);
+    std::shared_lock<std::shared_mutex> lock(mutex);
+    if (!dirty || !persistent)
+        return true;
+    QDir().mkpath(QFileInfo(filePath).absolutePath());
+    QSaveFile file(filePath);
+    if (!file.open(QIODevice::WriteOnly))
+        return false;
+    QDataStream out(&file);
+    out.setVersion(QDataStream::Qt_6_0);
+    out << CACHE_MAGIC << CACHE_VERSION << quint64(files.size());
+    for (const auto& [path, rec] : files) {
+        out << path << rec.key.device << rec.key.inode << rec.key.size << rec.key.mtime << rec.lastUsed
+            << quint8(rec.results.size());
+        for (const auto& r : rec.results)
+            out << r.query << r.cachedAt << r.matches;
+    }
+    if (out.status() != QDataStream::Ok || !file.commit())
+        return false;
+    dirty = false;
+    return true;
+}
+
+void MatchCache::clear()
+{
+    std::unique_lock<std::shared_mutex> lock(mutex);
+    files.clear();
+    dirty = true;
+}
+
+std::optional<bool> MatchCache::lookup(const QString& path, const FileKey& key, quint64 query) const
+{
+    ++nbrLookups;
+    if (!key.isValid())
+        return std::nullopt;
+    std::shared_lock<std::shared_mutex> lock(mutex);
+    const auto it = files.find(path);
+    if (it == files.end() || !(it->second.key == key))
+        return std::nullopt;
+    std::atomic_ref<quint64>(it->second.lastUsed).store(++useClock, std::memory_order_relaxed);
+    for (const auto& r : it->second.results) {
+        if (r.query == query && r.cachedAt - key.mtime >= MTIME_RESOLUTION_MS) {
+            ++nbrHits;
+            return r.matches;
+        }
+    }
+    return std::nullopt;
+}
+
+void MatchCache::store(const QString& path, const FileKey& key, quint64 query, bool matches)
+{
+    if (!key.isValid())
+        return;
+    const auto now = QDateTime::currentMSecsSinceEpoch();
+    std::unique_lock<std::shared_mutex> lock(mutex);
+    auto& rec = files[path];
+    if (!(rec.key == key)) {
+        // Changed: the results of the previous contents are void
+        rec.key = key;
+        rec.results.clear();
+    }
+    std::erase_if(rec.results, [query](const Result& r) { return r.query == query; });
+    if (rec.results.size() >= MAX_QUERIES_PER_FILE)
+        rec.results.erase(rec.results.begin());
+    rec.results.push_back({ query, now, matches });
+    rec.lastUsed = ++useClock;
+    dirty = true;
+    if (files.size() > MAX_FILES)
+        evict();
+}
+
+void MatchCache::evict()
+{
+    // Under the unique lock: drops the least recently used tenth of MAX_FILES
+    // at once, so that sorting the use times is done once per so many stores
+    std::vector<quint64> used;
+    used.reserve(files.size());
+    for (const auto& [path, rec] : files)
+        used.push_back(rec.lastUsed);
+    const auto nbrDropped = files.size() - MAX_FILES + MAX_FILES / 10;
+    std::nth_element(used.begin(), used.begin() + std::ptrdiff_t(nbrDropped - 1), used.end());
+    const auto oldest = used[nbrDropped - 1];
+    std::erase_if(files, [oldest](const auto& file) { return file.second.lastUsed <= oldest; });
+    dirty = true;
+}
+
+void MatchCache::resetStats()
+{
+    nbrLookups = 0;
+    nbrHits = 0;
+}
+
+}
@@ -0,0 +1,93 @@
+#pragma once
+//
+// Copyright (c) Milivoj (Mike) DAVIDOV
+//
+// THIS SOFTWARE IS PROVIDED "AS IS" WITHOUT WARRANTY OF ANY KIND,
+// EITHER EXPRESSED OR IMPLIED, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+// WARRANTIES OF MERCHANTABILITY AND/OR FITNESS FOR A PARTICULAR PURPOSE.
+//
+
+#include "contentindex.hpp"
+#include <atomic>
+#include <map>
+#include <mutex>
+#include <optional>
+#include <shared_mutex>
+#include <vector>
+#include <QString>
+
+namespace mmd
+{
+/// @brief Cache of content search results: for each file (by path and
+/// FileKey) whether it matched the last few queries (search and exclusion
+/// words and the options that change the result, see queryKey()).
+/// Re-running a word search (e.g. after changing only the name filter)
+/// then reads none of the files that are unchanged since.
+/// It is kept in memory for the app session, and optionally (setPersistent())
+/// in a binary file next to the app settings (Cfg), like the ScanIndex.
+/// At most MAX_FILES files are kept: beyond that the least recently used
+/// ones are dropped, a tenth of them at a time.
+/// All members are thread-safe.
+/// @author Milivoj (Mike) DAVIDOV
+///
+class MatchCache
+{
+public:
+    static constexpr std::size_t MAX_QUERIES_PER_FILE = 8;  // the oldest results are dropped
+    static constexpr std::size_t MAX_FILES = 250000;  // up to some 100 MB
+
+    explicit MatchCache(const QString& filePath);
+
+    /// Returns the cache file in the app settings location.
+    static QString defaultFilePath();
+    const QString& fileName() const { return filePath; }
+
+    /// A stable 64-bit key (FNV-1a) of a normalized query text
+    static quint64 queryKey(const QString& normalizedQuery);
+
+    /// Whether load() and save() use the file
+    void setPersistent(bool persist) { persistent = persist; }
+
+    /// @brief Loads the cache file once, if persistent (later calls do nothing).
+    /// A missing, corrupt or old-version file gives an empty cache.
+    void load();
+    /// Writes the cache file, if persistent and anything changed.
+    bool save();
+    void clear();
+
+    /// The result of @p query for the file at @p path, if it is unchanged since it was cached
+    std::optional<bool> lookup(const QString& path, const FileKey& key, quint64 query) const;
+    void store(const QString& path, const FileKey& key, quint64 query, bool matches);
+
+    /// Lookups, and those answered from the cache, since the last resetStats()
+    quint64 lookups() const { return nbrLookups; }
+    quint64 hits() const { return nbrHits; }
+    void resetStats();
+
+private:
+    struct Result {
+        quint64 query{ 0 };
+        qint64 cachedAt{ -1 };  // msec since epoch
+        bool matches{ false };
+    };
+    struct FileRecord {
+        FileKey key;
+        std::vector<Result> results;  // the newest last
+        // useClock when last looked up or stored; set under the shared lock (std::atomic_ref)
+        alignas(std::atomic_ref<quint64>::required_alignment) mutable quint64 lastUsed{ 0 };
+    };
+    void evict();
+
+    const QString filePath;
+    mutable std::shared_mutex mutex;
+    std::map<QString, FileRecord> files;
+    std::atomic<bool> persistent{ false };
+    bool loaded{ false };
+    bool dirty{ false };
+    std::mutex fileMutex;
+    mutable std::atomic<quint64> useClock{ 0 };
+    mutable std::atomic<quint64> nbrLookups{ 0 };
+    mutable std::atomic<quint64> nbrHits{ 0 };
+};
+
+}
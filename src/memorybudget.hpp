@@ -0,0 +1,135 @@
+#pragma once
+//
+// Copyright (c) Milivoj (Mike) DAVIDOV
+//
+// THIS SOFTWARE IS PROVIDED "AS IS" WITHOUT WARRANTY OF ANY KIND,
+// EITHER EXPRESSED OR IMPLIED, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+// WARRANTIES OF MERCHANTABILITY AND/OR FITNESS FOR A PARTICULAR PURPOSE.
+//
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <mutex>
+#include <utility>
+
+namespace mmd
+{
+/// @brief Caps the bytes held at the same time by several threads
+/// (e.g. the file windows of the content readers): a thread leases
+/// the bytes it needs before allocating or mapping them, waiting while
+/// the others hold too much, and gives them back when done (~Lease).
+/// A lease bigger than the whole budget waits until nothing else is held.
+/// A thread must not wait for a lease while it holds one: the threads could
+/// all hold one and wait for each other. The wait can be cancelled.
+/// @author Milivoj (Mike) DAVIDOV
+///
+class MemoryBudget
+{
+public:
+    static constexpr std::size_t DEFAULT_LIMIT = 64 * 1024 * 1024;
+
+    explicit MemoryBudget(std::size_t limit = DEFAULT_LIMIT)
+        : limit_(limit > 0 ? limit : DEFAULT_LIMIT)
+    {
+    }
+    MemoryBudget(const MemoryBudget&) = delete;
+    MemoryBudget& operator=(const MemoryBudget&) = delete;
+
+    std::size_t limit() const {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return limit_;
+    }
+
+    /// Changes the limit, e.g. before the next scan; 0 means DEFAULT_LIMIT
+    void setLimit(std::size_t limit) {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            limit_ = limit > 0 ? limit : DEFAULT_LIMIT;
+        }
+        released_.notify_all();
+    }
+
+    std::size_t used() const {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return used_;
+    }
+
+    /// Bytes held until destroyed (or moved from)
+    class Lease
+    {
+    public:
+        Lease() = default;
+        Lease(Lease&& other) noexcept
+            : budget_(std::exchange(other.budget_, nullptr))
+            , bytes_(std::exchange(other.bytes_, 0))
+        {
+        }
+        Lease& operator=(Lease&& other) noexcept {
+            if (this != &other) {
+                reset();
+                budget_ = std::exchange(other.budget_, nullptr);
+                bytes_ = std::exchange(other.bytes_, 0);
+            }
+            return *this;
+        }
+        ~Lease() { reset(); }
+
+        std::size_t bytes() const { return bytes_; }
+
+        void reset() {
+            if (budget_)
+                budget_->release(bytes_);
+            budget_ = nullptr;
+            bytes_ = 0;
+        }
+
+    private:
+        friend class MemoryBudget;
+        Lease(MemoryBudget* budget, std::size_t bytes)
+            : budget_(budget)
+            , bytes_(bytes)
+        {
+        }
+        MemoryBudget* budget_{ nullptr };
+        std::size_t bytes_{ 0 };
+    };
+
+    /// @brief Waits until @p bytes fit in the budget and holds them.
+    /// @return An empty lease (no bytes) if @p cancel was set meanwhile (see wakeAll()).
+    Lease lease(std::size_t bytes, const std::atomic<bool>* cancel = nullptr) {
+        std::unique_lock<std::mutex> lock(mutex_);
+        released_.wait(lock, [this, bytes, cancel]() {
+            return (cancel && *cancel) || used_ == 0 || used_ + bytes <= limit_;
+        });
+        if (cancel && *cancel)
+            return Lease();
+        used_ += bytes;
+        return Lease(this, bytes);
+    }
+
+    /// Wakes the threads waiting in lease(), after setting their cancel flag
+    void wakeAll() {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+        }
+        released_.notify_all();
+    }
+
+private:
+    void release(std::size_t bytes) {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            used_ -= std::min(bytes, used_);
+        }
+        released_.notify_all();
+    }
+
+    mutable std::mutex mutex_;
+    std::condition_variable released_;
+    std::size_t limit_;
+    std::size_t used_{ 0 };
+};
+
+}
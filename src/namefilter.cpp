@@ -0,0 +1,254 @@
+//
+// Copyright (c) Milivoj (Mike) DAVIDOV
+//
+// THIS SOFTWARE IS PROVIDED "AS IS" WITHOUT WARRANTY OF ANY KIND,
+// EITHER EXPRESSED OR IMPLIED, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+// WARRANTIES OF MERCHANTABILITY AND/OR FITNESS FOR A PARTICULAR PURPOSE.
+//
+
+#include "namefilter.hpp"
+#include "regexmatcher.hpp"
+#include <algorithm>
+#include <bitset>
+#include <QByteArray>
+#include <QDir>
+
+namespace mmd
+{
+namespace
+{
+using ByteSet = std::bitset<256>;
+
+char toLowerAscii(char c)
+{
+    return (c >= 'A' && c <= 'Z') ? char(c - 'A' + 'a') : c;
+}
+
+bool isAscii(const QString& str)
+{
+    for (const auto ch : str) {
+        if (ch.unicode() >= 0x80)
+            return false;
+    }
+    return true;
+}
+
+bool equalsNoCase(const char* a, const std::string& lowerB)
+{
+    for (std::size_t i = 0; i < lowerB.size(); ++i) {
+        if (toLowerAscii(a[i]) != lowerB[i])
+            return false;
+    }
+    return true;
+}
+
+void addNoCase(ByteSet& set, char c)
+{
+    set.set(static_cast<unsigned char>(c));
+    if (c >= 'a' && c <= 'z')
+        set.set(static_cast<unsigned char>(c - 'a' + 'A'));
+    else if (c >= 'A' && c <= 'Z')
+        set.set(static_cast<unsigned char>(c - 'A' + 'a'));
+}
+
+/// Any UTF-8 character: ASCII bytes and lead bytes (continuation bytes are skipped)
+ByteSet anyChar()
+{
+    ByteSet set;
+    set.set();
+    for (unsigned b = 0x80; b < 0xC0; ++b)
+        set.reset(b);
+    return set;
+}
+
+/// A glob pattern as tokens; loops[j]: a '*' before token j (j == tokens.size(): at the end)
+struct Glob
+{
+    std::vector<ByteSet> tokens;
+    std::vector<bool> loops;
+};
+
+Glob parseGlob(const std::string& p)
+{
+    Glob glob;
+    glob.loops.push_back(false);
+    for (std::size_t i = 0; i < p.size(); ++i) {
+        ByteSet set;
+        if (p[i] == '*') {
+            glob.loops.back() = true;
+            continue;
+        }
+        if (p[i] == '?') {
+            set = anyChar();
+        }
+        else if (p[i] == '[') {
+            auto j = i + 1;
+            const auto negated = j < p.size() && (p[j] == '!' || p[j] == '^');
+            if (negated)
+                ++j;
+            const auto first = j;
+            // A ']' right after '[' or '[!' is a member
+            while (j < p.size() && (p[j] != ']' || j == first))
+                ++j;
+            if (j >= p.size()) {
+                addNoCase(set, '[');  // no closing ']'
+            }
+            else {
+                for (auto k = first; k < j; ++k) {
+                    if (k + 2 < j && p[k + 1] == '-') {
+                        for (int c = p[k]; c <= p[k + 2]; ++c)
+                            addNoCase(set, char(c));
+                        k += 2;
+                    }
+                    else {
+                        addNoCase(set, p[k]);
+                    }
+                }
+                if (negated)
+                    set = ~set & anyChar();
+                i = j;
+            }
+        }
+        else {
+            addNoCase(set, p[i]);
+        }
+        glob.tokens.push_back(set);
+        glob.loops.push_back(false);
+    }
+    return glob;
+}
+}
+
+NameFilter::NameFilter(const QStringList& patterns, bool regex, bool wholeWords)
+    : empty(patterns.isEmpty())
+{
+    if (regex) {
+        for (const auto& pattern : patterns) {
+            regexes.emplace_back(wholeWords ? RegexMatcher::wholeWordPattern(pattern) : pattern,
+                                 QRegularExpression::CaseInsensitiveOption);
+            regexes.back().optimize();
+        }
+        return;
+    }
+    std::vector<Glob> globs;
+    for (const auto& pattern : patterns) {
+        if (!isAscii(pattern)) {
+            otherPatterns.append(pattern);
+            continue;
+        }
+        std::string p = pattern.toStdString();
+        for (auto& c : p)
+            c = toLowerAscii(c);
+        if (p.find_first_of("?[") == std::string::npos) {
+            const auto star = p.rfind('*');
+            if (star == std::string::npos) {
+                literals.push_back(p);
+                continue;
+            }
+            if (star == 0) {
+                suffixes.push_back(p.substr(1));
+                continue;
+            }
+        }
+        globs.push_back(parseGlob(p));
+    }
+
+    for (const auto& glob : globs)
+        nbrBits += glob.tokens.size() + 1;
+    nbrWords = (nbrBits + 63) / 64;
+    tokenMasks.assign(256 * nbrWords, 0);
+    startBits.assign(nbrWords, 0);
+    loopBits.assign(nbrWords, 0);
+    finalBits.assign(nbrWords, 0);
+    const auto setBit = [](std::vector<std::uint64_t>& bits, std::size_t bit) {
+        bits[bit / 64] |= std::uint64_t(1) << (bit % 64);
+    };
+    std::size_t offset = 0;
+    for (const auto& glob : globs) {
+        setBit(startBits, offset);
+        for (std::size_t j = 0; j < glob.tokens.size(); ++j) {
+            for (std::size_t b = 0; b < 256; ++b) {
+                if (glob.tokens[j].test(b))
+                    tokenMasks[b * nbrWords + (offset + j) / 64] |= std::uint64_t(1) << ((offset + j) % 64);
+            }
+        }
+        for (std::size_t j = 0; j < glob.loops.size(); ++j) {
+            if (glob.loops[j])
+                setBit(loopBits, offset + j);
+        }
+        offset += glob.tokens.size();
+        setBit(finalBits, offset);
+        ++offset;
+    }
+}
+
+bool NameFilter::matches(const char* name, std::size_t len) const
+{
+    if (empty)
+        return true;
+    if (!regexes.empty())
+        return matches(QString::fromUtf8(name, qsizetype(len)));
+    for (const auto& suffix : suffixes) {
+        if (len >= suffix.size() && equalsNoCase(name + len - suffix.size(), suffix))
+            return true;
+    }
+    for (const auto& literal : literals) {
+        if (len == literal.size() && equalsNoCase(name, literal))
+            return true;
+    }
+    if (nbrWords > 0 && globMatches(name, len))
+        return true;
+    return !otherPatterns.isEmpty() &&
+        QDir::match(otherPatterns, QString::fromUtf8(name, qsizetype(len)));
+}
+
+bool NameFilter::matches(const QString& name) const
+{
+    if (empty)
+        return true;
+    if (!regexes.empty()) {
+        return std::any_of(regexes.cbegin(), regexes.cend(),
+            [&name](const QRegularExpression& regex) { return regex.match(name).hasMatch(); });
+    }
+    const auto utf8 = name.toUtf8();
+    return matches(utf8.constData(), std::size_t(utf8.size()));
+}
+
+bool NameFilter::globMatches(const char* name, std::size_t len) const
+{
+    // Up to 4 words (256 pattern positions) on the stack
+    std::uint64_t stackState[4];
+    std::vector<std::uint64_t> heapState;
+    std::uint64_t* state = stackState;
+    if (nbrWords > 4) {
+        heapState.resize(nbrWords);
+        state = heapState.data();
+    }
+    for (std::size_t w = 0; w < nbrWords; ++w)
+        state[w] = startBits[w];
+
+    for (std::size_t i = 0; i < len; ++i) {
+        const auto byte = static_cast<unsigned char>(name[i]);
+        if ((byte & 0xC0) == 0x80)
+            continue;  // UTF-8 continuation byte
+        const auto* masks = &tokenMasks[byte * nbrWords];
+        std::uint64_t carry = 0;
+        std::uint64_t any = 0;
+        for (std::size_t w = 0; w < nbrWords; ++w) {
+            const auto advanced = state[w] & masks[w];
+            const auto next = (advanced << 1) | carry | (state[w] & loopBits[w]);
+            carry = advanced >> 63;
+            state[w] = next;
+            any |= next;
+        }
+        if (any == 0)
+            return false;
+    }
+    for (std::size_t w = 0; w < nbrWords; ++w) {
+        if (state[w] & finalBits[w])
+            return true;
+    }
+    return false;
+}
+
+}
@@ -0,0 +1,67 @@
+#pragma once
+//
+// Copyright (c) Milivoj (Mike) DAVIDOV
+//
+// THIS SOFTWARE IS PROVIDED "AS IS" WITHOUT WARRANTY OF ANY KIND,
+// EITHER EXPRESSED OR IMPLIED, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+// WARRANTIES OF MERCHANTABILITY AND/OR FITNESS FOR A PARTICULAR PURPOSE.
+//
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <QRegularExpression>
+#include <QString>
+#include <QStringList>
+
+namespace mmd
+{
+/// @brief File name wildcard filter (as QDir::match: *, ? and [...] sets,
+/// case-insensitive), compiled once and evaluated on UTF-8 name bytes.
+/// - "*.ext" patterns are a case-insensitive suffix compare, and patterns
+///   without wildcards an equality compare.
+/// - All the other patterns are simulated together by one bit-parallel
+///   automaton (one bit per pattern position, a few shifts and masks
+///   per byte), i.e. the name is read once for all of them.
+/// UTF-8 continuation bytes are skipped by the automaton, so ? and sets
+/// match one whole character. Patterns with non-ASCII characters
+/// (which need Unicode case folding) fall back to QDir::match().
+/// The patterns may be (case-insensitive) regular expressions instead,
+/// found anywhere in the name, or only as whole words of it.
+/// (Wildcard patterns always match the whole name.)
+/// @author Milivoj (Mike) DAVIDOV
+///
+class NameFilter
+{
+public:
+    NameFilter() = default;
+    explicit NameFilter(const QStringList& patterns, bool regex = false, bool wholeWords = false);
+
+    /// No patterns: everything matches.
+    bool isEmpty() const { return empty; }
+
+    /// @p name is UTF-8 (as file names on Linux / macOS)
+    bool matches(const char* name, std::size_t len) const;
+    bool matches(const QString& name) const;
+
+private:
+    bool compileGlob(const QString& pattern);
+    bool globMatches(const char* name, std::size_t len) const;
+
+    bool empty{ true };
+    std::vector<std::string> suffixes;  // lower case, from "*.ext"
+    std::vector<std::string> literals;  // lower case
+    QStringList otherPatterns;          // for QDir::match()
+    std::vector<QRegularExpression> regexes;
+
+    // Bit-parallel glob automaton. Bit j of a pattern = its first j tokens matched.
+    std::size_t nbrBits{ 0 };
+    std::size_t nbrWords{ 0 };
+    std::vector<std::uint64_t> tokenMasks;  // [byte * nbrWords + w]: tokens matching that byte
+    std::vector<std::uint64_t> startBits;
+    std::vector<std::uint64_t> loopBits;    // states with a '*' (stay on any character)
+    std::vector<std::uint64_t> finalBits;
+};
+
+}
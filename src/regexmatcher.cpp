@@ -0,0 +1,317 @@
+//
+// Copyright (c) Milivoj (Mike) DAVIDOV
+//
+// THIS SOFTWARE IS PROVIDED "AS IS" WITHOUT WARRANTY OF ANY KIND,
+// EITHER EXPRESSED OR IMPLIED, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+// WARRANTIES OF MERCHANTABILITY AND/OR FITNESS FOR A PARTICULAR PURPOSE.
+//
+
+#include "regexmatcher.hpp"
+#include <string_view>
+#include <QByteArray>
+
+namespace mmd
+{
+namespace
+{
+char toLowerAscii(char c)
+{
+    return (c >= 'A' && c <= 'Z') ? char(c - 'A' + 'a') : c;
+}
+
+/// Index of the character after the set starting at @p i ('['), or after the end
+qsizetype skipSet(const QString& p, qsizetype i)
+{
+    // A ']' right after '[' or "[^" is in the set
+    ++i;
+    if (i < p.size() && p[i] == u'^')
+        ++i;
+    if (i < p.size() && p[i] == u']')
+        ++i;
+    while (i < p.size() && p[i] != u']')
+        i += (p[i] == u'\\') ? 2 : 1;
+    return i + 1;
+}
+
+/// Index of the character after the group starting at @p i ('('), or after the end
+qsizetype skipGroup(const QString& p, qsizetype i)
+{
+    auto depth = 0;
+    while (i < p.size()) {
+        const auto c = p[i];
+        if (c == u'\\') {
+            i += 2;
+            continue;
+        }
+        if (c == u'[') {
+            i = skipSet(p, i);
+            continue;
+        }
+        if (c == u'(')
+            ++depth;
+        else if (c == u')' && --depth == 0)
+            return i + 1;
+        ++i;
+    }
+    return i;
+}
+
+/// The top level alternatives of @p p
+QStringList splitAlternatives(const QString& p)
+{
+    QStringList alternatives;
+    qsizetype start = 0;
+    qsizetype i = 0;
+    while (i < p.size()) {
+        const auto c = p[i];
+        if (c == u'\\') {
+            i += 2;
+        }
+        else if (c == u'[') {
+            i = skipSet(p, i);
+        }
+        else if (c == u'(') {
+            i = skipGroup(p, i);
+        }
+        else if (c == u'|') {
+            alternatives.append(p.mid(start, i - start));
+            start = ++i;
+        }
+        else {
+            ++i;
+        }
+    }
+    alternatives.append(p.mid(start));
+    return alternatives;
+}
+
+/// The longest string of literal characters that every match of @p p
+/// (one alternative) contains, as UTF-8
+std::string longestLiteral(const QString& p)
+{
+    QString literal;
+    std::string longest;
+    auto lastIsLiteral = false;  // the last atom is the last character of literal
+    const auto endLiteral = [&]() {
+        const auto utf8 = literal.toUtf8();
+        if (std::size_t(utf8.size()) > longest.size())
+            longest.assign(utf8.constData(), std::size_t(utf8.size()));
+        literal.clear();
+        lastIsLiteral = false;
+    };
+    const auto dropLast = [&]() {
+        // The last atom is optional or repeated: not part of the literal
+        if (lastIsLiteral && !literal.isEmpty()) {
+            literal.chop(literal.size() > 1 && literal.back().isLowSurrogate() ? 2 : 1);
+        }
+        endLiteral();
+    };
+    qsizetype i = 0;
+    while (i < p.size()) {
+        const auto c = p[i];
+        if (c == u'\\') {
+            if (i + 1 >= p.size())
+                return {};
+            const auto e = p[i + 1];
+            if (e.isLetterOrNumber()) {
+                // \d, \w, \b, \n, etc.; others (\x41, \pL, \Q...\E,
+                // back references, etc.) are longer: don't try to tell
+                if (!QStringLiteral("dDwWsSbBhHvVRNnrtfeaAzZGXK").contains(e))
+                    return {};
+                endLiteral();
+                i += 2;
+                continue;
+            }
+            literal += e;
+            lastIsLiteral = true;
+            i += 2;
+        }
+        else if (c == u'[' || c == u'(') {
+            endLiteral();
+            i = (c == u'[') ? skipSet(p, i) : skipGroup(p, i);
+        }
+        else if (c == u'*' || c == u'?') {
+            dropLast();
+            ++i;
+        }
+        else if (c == u'{') {
+            dropLast();
+            const auto close = p.indexOf(u'}', i);
+            i = close < 0 ? p.size() : close + 1;
+        }
+        else if (c == u'+' || c == u'.' || c == u'^' || c == u'$' || c == u'\n' || c == u'\r') {
+            // x+ needs one x, so the literal ends with it
+            endLiteral();
+            ++i;
+        }
+        else {
+            literal += c;
+            lastIsLiteral = true;
+            ++i;
+        }
+    }
+    endLiteral();
+    return longest;
+}
+}
+
+std::vector<std::string> RegexMatcher::requiredLiterals(const QString& pattern, bool matchCase)
+{
+    // Inline options, e.g. (?i) or (?x), change what is literal
+    if (pattern.contains(QStringLiteral("(?")) || pattern.contains(QStringLiteral("(*")))
+        return {};
+    std::vector<std::string> literals;
+    for (const auto& alternative : splitAlternatives(pattern)) {
+        auto literal = longestLiteral(alternative);
+        if (literal.size() < MIN_LITERAL_SIZE)
+            return {};
+        if (!matchCase) {
+            for (auto& c : literal) {
+                // Non-ASCII letters need Unicode case folding
+                if (c & 0x80)
+                    return {};
+                c = toLowerAscii(c);
+            }
+        }
+        literals.push_back(std::move(literal));
+    }
+    return literals;
+}
+
+QString RegexMatcher::wholeWordPattern(const QString& pattern)
+{
+    // Lookarounds rather than \b, which is ASCII only and needs a word character at the ends
+    const auto wordChar = QStringLiteral("[\\w\\x{80}-\\x{10FFFF}]");
+    return QStringLiteral("(?<!") + wordChar + QStringLiteral(")(?:") + pattern +
+        QStringLiteral(")(?!") + wordChar + QStringLiteral(")");
+}
+
+RegexMatcher::RegexMatcher(const QString& pattern, bool matchCase, bool wholeWords)
+    : regex(wholeWords ? wholeWordPattern(pattern) : pattern, matchCase ?
+        QRegularExpression::MultilineOption :
+        QRegularExpression::MultilineOption | QRegularExpression::CaseInsensitiveOption)
+    , empty(pattern.isEmpty())
+{
+    if (empty || !regex.isValid())
+        return;
+    regex.optimize();
+    // Anchored to the whole text, not to lines
+    lineByLine = pattern.contains(QStringLiteral("\\A")) || pattern.contains(QStringLiteral("\\z")) ||
+        pattern.contains(QStringLiteral("\\Z")) || pattern.contains(QStringLiteral("\\G"));
+    // The literals of the pattern as given (the lookarounds add none)
+    prefilterLiterals = requiredLiterals(pattern, matchCase);
+    if (prefilterLiterals.size() == 1)
+        literalSearcher = SubstringSearcher(prefilterLiterals.front(), matchCase);
+    else if (prefilterLiterals.size() > 1)
+        literalMatcher = AhoCorasick<char>(prefilterLiterals, matchCase ? nullptr : toLowerAscii);
+}
+
+std::size_t RegexMatcher::findLiteral(const char* text, std::size_t len) const
+{
+    if (!literalSearcher.isEmpty())
+        return literalSearcher.find(text, len);
+    auto state = literalMatcher.start();
+    for (std::size_t i = 0; i < len; ++i) {
+        state = literalMatcher.step(state, text[i]);
+        if (literalMatcher.isMatch(state))
+            return i;  // the last byte of the literal
+    }
+    return std::string_view::npos;
+}
+
+bool RegexMatcher::eachLineMatches(const char* data, std::size_t len) const
+{
+    const std::string_view text(data, len);
+    std::size_t begin = 0;
+    while (begin <= len) {
+        auto end = text.find('\n', begin);
+        if (end == std::string_view::npos)
+            end = len;
+        if (regex.match(QString::fromUtf8(data + begin, qsizetype(end - begin))).hasMatch())
+            return true;
+        begin = end + 1;
+    }
+    return false;
+}
+
+bool RegexMatcher::linesMatch(const char* data, std::size_t len) const
+{
+    if (prefilterLiterals.empty()) {
+        if (lineByLine)
+            return eachLineMatches(data, len);
+        // All the lines at once: in multi-line mode a match within a line
+        // is also a match here, but one here may span lines (e.g. \s+)
+        const auto match = regex.match(QString::fromUtf8(data, qsizetype(len)));
+        if (!match.hasMatch())
+            return false;
+        return !match.captured(0).contains(u'\n') || eachLineMatches(data, len);
+    }
+    // Only the lines with a literal (which has no line break)
+    const std::string_view text(data, len);
+    std::size_t from = 0;
+    while (from < len) {
+        const auto hit = findLiteral(data + from, len - from);
+        if (hit == std::string_view::npos)
+            return false;
+        const auto lineStart = text.rfind('\n', from + hit);
+        const auto begin = (lineStart == std::string_view::npos || lineStart < from) ? from : lineStart + 1;
+        auto end = text.find('\n', from + hit);
+        if (end == std::string_view::npos)
+            end = len;
+        if (regex.match(QString::fromUtf8(data + begin, qsizetype(end - begin))).hasMatch())
+            return true;
+        from = end + 1;
+    }
+    return false;
+}
+
+bool RegexMatcher::keepLine(Progress& progress, const char* data, std::size_t len) const
+{
+    progress.line.append(data, len);
+    if (progress.line.size() < MAX_LINE_SIZE)
+        return false;
+    // Too long for a line of text: cut it
+    progress.found = linesMatch(progress.line.data(), progress.line.size());
+    progress.line.clear();
+    return progress.found;
+}
+
+bool RegexMatcher::feed(Progress& progress, const char* data, std::size_t len) const
+{
+    if (empty || progress.found)
+        return progress.found;
+    const std::string_view text(data, len);
+    std::size_t start = 0;
+    if (!progress.line.empty()) {
+        // The rest of the line started in the previous block
+        const auto lineEnd = text.find('\n');
+        if (lineEnd == std::string_view::npos)
+            return keepLine(progress, data, len);
+        progress.line.append(data, lineEnd);
+        progress.found = linesMatch(progress.line.data(), progress.line.size());
+        progress.line.clear();
+        if (progress.found)
+            return true;
+        start = lineEnd + 1;
+    }
+    // Whole lines, then the start of the last one
+    const auto lastEnd = text.rfind('\n');
+    if (lastEnd != std::string_view::npos && lastEnd >= start) {
+        progress.found = linesMatch(data + start, lastEnd - start);
+        if (progress.found)
+            return true;
+        start = lastEnd + 1;
+    }
+    return keepLine(progress, data + start, len - start);
+}
+
+bool RegexMatcher::finish(Progress& progress) const
+{
+    if (!progress.found && !progress.line.empty()) {
+        progress.found = linesMatch(progress.line.data(), progress.line.size());
+        progress.line.clear();
+    }
+    return progress.found;
+}
+
+}
@@ -0,0 +1,82 @@
+#pragma once
+//
+// Copyright (c) Milivoj (Mike) DAVIDOV
+//
+// THIS SOFTWARE IS PROVIDED "AS IS" WITHOUT WARRANTY OF ANY KIND,
+// EITHER EXPRESSED OR IMPLIED, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+// WARRANTIES OF MERCHANTABILITY AND/OR FITNESS FOR A PARTICULAR PURPOSE.
+//
+
+#include "ahocorasick.hpp"
+#include "substringsearcher.hpp"
+#include <cstddef>
+#include <string>
+#include <vector>
+#include <QRegularExpression>
+#include <QString>
+
+namespace mmd
+{
+/// @brief Finds a regular expression in file contents (UTF-8 bytes),
+/// line by line (a match does not span lines; ^ and $ match at line ends).
+/// The regular expression is compiled once, and literals that every match
+/// must contain are extracted from it (e.g. "error" from "error: \d+",
+/// one per alternative of "foo\w*|bar"): the bytes are first scanned for
+/// those literals with the SIMD SubstringSearcher (one literal) or an
+/// Aho-Corasick automaton (several), and the regex engine only runs on the
+/// lines where one is found. Without such literals it runs on all lines.
+/// Lines are carried from one block of a file to the next (see Progress),
+/// so blocks need no overlap.
+/// Whole words: the match must not have word characters around it (as
+/// ContentMatcher: letters, digits, '_' and non-ASCII characters).
+/// Compiled once per scan; const, so it can be shared by several threads.
+/// @author Milivoj (Mike) DAVIDOV
+///
+class RegexMatcher
+{
+public:
+    static constexpr std::size_t MIN_LITERAL_SIZE = 3;  // bytes, shorter ones hit too often
+    static constexpr std::size_t MAX_LINE_SIZE = 1024 * 1024;  // longer lines are cut
+
+    RegexMatcher() = default;
+    RegexMatcher(const QString& pattern, bool matchCase, bool wholeWords = false);
+
+    bool isEmpty() const { return empty; }
+    bool isValid() const { return regex.isValid(); }
+    QString errorString() const { return regex.errorString(); }
+
+    /// The literals found in the pattern: every match contains one of them
+    /// (ASCII lower case if not matchCase); none if they cannot be told
+    const std::vector<std::string>& literals() const { return prefilterLiterals; }
+    static std::vector<std::string> requiredLiterals(const QString& pattern, bool matchCase);
+    /// @p pattern, only matching whole words
+    static QString wholeWordPattern(const QString& pattern);
+
+    /// Matching state of one file
+    struct Progress
+    {
+        std::string line;  // start of a line continued in the next block
+        bool found{ false };
+    };
+
+    /// @brief Feeds the next @p len bytes of the file.
+    /// Returns early (true) when a match is found.
+    bool feed(Progress& progress, const char* data, std::size_t len) const;
+    /// Checks the last line (after the last block was fed)
+    bool finish(Progress& progress) const;
+
+private:
+    bool linesMatch(const char* data, std::size_t len) const;
+    bool eachLineMatches(const char* data, std::size_t len) const;
+    std::size_t findLiteral(const char* text, std::size_t len) const;
+    bool keepLine(Progress& progress, const char* data, std::size_t len) const;
+
+    QRegularExpression regex;
+    bool empty{ true };
+    bool lineByLine{ false };  // the regex cannot run on several lines at once
+    std::vector<std::string> prefilterLiterals;
+    SubstringSearcher literalSearcher;  // if one literal
+    AhoCorasick<char> literalMatcher;   // if several
+};
+
+}
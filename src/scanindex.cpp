@@ -0,0 +1,312 @@
+//
+// Copyright (c) Milivoj (Mike) DAVIDOV
+//
+// THIS SOFTWARE IS PROVIDED "AS IS" WITHOUT WARRANTY OF ANY KIND,
+// EITHER EXPRESSED OR IMPLIED, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+// WARRANTIES OF MERCHANTABILITY AND/OR FITNESS FOR A PARTICULAR PURPOSE.
+//
+
+#include "scanindex.hpp"
+#include "config.hpp"
+#include <algorithm>
+#include <set>
+#include <QDataStream>
+#include <QDateTime>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QSaveFile>
+#include <QSettings>
+#include <QStandardPaths>
+#include <QDebug>
+
+namespace mmd
+{
+namespace
+{
+constexpr quint32 INDEX_MAGIC = 0x4D534958;  // "MSIX"
+constexpr quint32 INDEX_VERSION = 1;
+
+// Folder mtimes have a coarse granularity on some file systems (2 sec on FAT),
+// so a folder read within that long of its last change may change again
+// without a new mtime: such a listing is not trusted.
+constexpr qint64 MTIME_RESOLUTION_MS = 2000;
+
+// size, mtime, nameOffset, type, hidden as written by QDataStream
+constexpr qint64 ENTRY_DISK_SIZE = 8 + 8 + 4 + 1 + 1;
+
+QString childPath(const QString& dirPath, const QString& name)
+{
+    return dirPath.endsWith(QLatin1Char('/')) ? dirPath + name : dirPath + QChar('/') + name;
+}
+
+qint64 dirModTime(const QString& dirPath)
+{
+    const QFileInfo info(dirPath);
+    if (!info.exists())
+        return -1;
+    return info.lastModified().toMSecsSinceEpoch();
+}
+}
+
+ScanIndex::ScanIndex(const QString& indexFilePath)
+    : filePath(indexFilePath)
+{
+}
+
+QString ScanIndex::defaultFilePath()
+{
+#if defined(Q_OS_WIN)
+    // The native settings are in the registry there
+    const auto dirPath = QStandardPaths::writableLocation(QStandardPaths::AppLocalDataLocation);
+#else
+    const auto dirPath = QFileInfo(Cfg::St().fileName()).absolutePath();
+#endif
+    return dirPath + QStringLiteral("/scanindex.bin");
+}
+
+void ScanIndex::load()
+{
+    std::lock_guard<std::mutex> fileLock(fileMutex);
+    if (loaded)
+        return;
+    loaded = true;
+    QFile file(filePath);
+    if (!file.open(QIODevice::ReadOnly))
+        return;
+    QDataStream in(&file);
+    in.setVersion(QDataStream::Qt_6_0);
+    quint32 magic = 0;
+    quint32 version = 0;
+    quint64 nbrDirs = 0;
+    in >> magic >> version >> nbrDirs;
+    if (magic != INDEX_MAGIC || version != INDEX_VERSION)
+        return;
+
+    std::map<QString, DirRecord> loadedDirs;
+    for (quint64 d = 0; d < nbrDirs && in.status() == QDataStream::Ok; ++d) {
+        QString path;
+        DirRecord rec;
+        quint32 nbrEntries = 0;
+        in >> path >> rec.mtime >> rec.listedAt >> rec.names >> nbrEntries;
+        if (in.status() != QDataStream::Ok)
+            break;
+        if (qint64(nbrEntries) > (file.size() - file.pos()) / ENTRY_DISK_SIZE) {
+            in.setStatus(QDataStream::ReadCorruptData);
+            break;
+        }
+        rec.entries.resize(nbrEntries);
+        for (auto& e : rec.entries) {
+            in >> e.size >> e.mtime >> e.nameOffset >> e.type >> e.hidden;
+            if (e.nameOffset >= quint32(rec.names.size())) {
+                in.setStatus(QDataStream::ReadCorruptData);
+                break;
+            }
+        }
+        loadedDirs.emplace_hint(loadedDirs.end(), std::move(path), std::move(rec));
+    }
+    if (in.status() != QDataStream::Ok) {
+        qDebug() << "Ignoring corrupt scan index" << filePath;
+        return;
+    }
+    std::unique_lock<std::shared_mutex> lock(mutex);
+    // Folders stored before loading finished are newer, so they are kept
+    dirs.merge(loadedDirs);
+}
+
+bool ScanIndex::save()
+{
+    std::lock_guard<std::mutex> fileLock(fileMutex);
+    std::shared_lock<std::shared_mutex> lock(mutex);
+    if (!dirty)
+        return true;
+    QDir().mkpath(QFileInfo(filePath).absolutePath());
+    QSaveFile file(filePath);
+    if (!file.open(QIODevice::WriteOnly))
+        return false;
+    QDataStream out(&file);
+    out.setVersion(QDataStream::Qt_6_0);
+    out << INDEX_MAGIC << INDEX_VERSION << quint64(dirs.size());
+    for (const auto& [path, rec] : dirs) {
+        out << path << rec.mtime << rec.listedAt << rec.names << quint32(rec.entries.size());
+        for (const auto& e : rec.entries)
+            out << e.size << e.mtime << e.nameOffset << e.type << e.hidden;
+    }
+    if (out.status() != QDataStream::Ok || !file.commit())
+        return false;
+    dirty = false;
+    return true;
+}
+
+bool ScanIndex::lookup(const QString& dirPath, qint64 dirMtime, std::vector<FsEntry>& entries) const
+{
+    entries.clear();
+    std::shared_lock<std::shared_mutex> lock(mutex);
+    const auto it = dirs.find(dirPath);
+    if (it == dirs.end())
+        return false;
+    const auto& rec = it->second;
+    if (dirMtime < 0 || rec.mtime != dirMtime || rec.listedAt - rec.mtime < MTIME_RESOLUTION_MS)
+        return false;
+    getEntries(dirPath, rec, entries);
+    return true;
+}
+
+bool ScanIndex::lookup(const QString& dirPath, std::vector<FsEntry>& entries) const
+{
+    entries.clear();
+    std::shared_lock<std::shared_mutex> lock(mutex);
+    const auto it = dirs.find(dirPath);
+    if (it == dirs.end())
+        return false;
+    getEntries(dirPath, it->second, entries);
+    return true;
+}
+
+void ScanIndex::getEntries(const QString& dirPath, const DirRecord& rec, std::vector<FsEntry>& entries) const
+{
+    entries.resize(rec.entries.size());
+    const auto* names = rec.names.constData();
+    for (size_t i = 0; i < rec.entries.size(); ++i) {
+        const auto& e = rec.entries[i];
+        auto& entry = entries[i];
+        entry.name = QString::fromUtf8(names + e.nameOffset);
+        entry.path = childPath(dirPath, entry.name);
+        entry.type = FsEntry::Type(e.type);
+        entry.hidden = e.hidden != 0;
+        entry.size = e.size;
+        entry.mtime = e.mtime;
+    }
+    ++nbrReused;
+}
+
+void ScanIndex::store(const QString& dirPath, qint64 dirMtime, const std::vector<FsEntry>& entries)
+{
+    DirRecord rec;
+    rec.mtime = dirMtime;
+    rec.listedAt = QDateTime::currentMSecsSinceEpoch();
+    rec.entries.reserve(entries.size());
+    std::set<QString> subDirNames;
+    for (const auto& entry : entries) {
+        EntryRecord e;
+        e.size = entry.size;
+        e.mtime = entry.mtime;
+        e.nameOffset = quint32(rec.names.size());
+        e.type = quint8(entry.type);
+        e.hidden = entry.hidden ? 1 : 0;
+        rec.names += entry.name.toUtf8();
+        rec.names += '\0';
+        rec.entries.push_back(e);
+        if (entry.isDir())
+            subDirNames.insert(entry.name);
+    }
+    ++nbrRead;
+
+    std::unique_lock<std::shared_mutex> lock(mutex);
+    const auto it = dirs.find(dirPath);
+    if (it != dirs.end()) {
+        // Sub-folders that were deleted or renamed take their indexed sub-trees along
+        const auto& old = it->second;
+        for (const auto& e : old.entries) {
+            if (e.type != quint8(FsEntry::Type::Dir))
+                continue;
+            const auto name = QString::fromUtf8(old.names.constData() + e.nameOffset);
+            if (!subDirNames.contains(name))
+                eraseSubtree(childPath(dirPath, name));
+        }
+    }
+    dirs[dirPath] = std::move(rec);
+    dirty = true;
+}
+
+void ScanIndex::eraseSubtree(const QString& dirPath)
+{
+    dirs.erase(dirPath);
+    const auto prefix = childPath(dirPath, QString());
+    auto it = dirs.lower_bound(prefix);
+    while (it != dirs.end() && it->first.startsWith(prefix))
+        it = dirs.erase(it);
+}
+
+void ScanIndex::clear()
+{
+    std::unique_lock<std::shared_mutex> lock(mutex);
+    dirs.clear();
+    dirty = true;
+    if (watcher)
+        watcher->reset();
+}
+
+void ScanIndex::setDirWatcher(std::unique_ptr<DirWatcher> dirWatcher)
+{
+    watcher = std::move(dirWatcher);
+}
+
+void ScanIndex::resetStats()
+{
+    nbrReused = 0;
+    nbrRead = 0;
+}
+
+
+IndexedDirLister::IndexedDirLister(const ScanParams& scanParams, ScanIndex& scanIndex)
+    : DirLister(scanParams)
+    , index(scanIndex)
+    , allParams(scanParams)
+{
+    allParams.nameFilters.clear();
+    allParams.exclHidden = false;
+    allParams.itemTypeFilter = QDir::AllEntries | QDir::System | QDir::Hidden;
+    allLister = DirLister::create(allParams, StatSize | StatMTime);
+}
+
+bool IndexedDirLister::list(const QString& dirPath, DirListing& out) const
+{
+    out.clear();
+    std::vector<FsEntry> entries;
+    auto* watcher = index.dirWatcher();
+    // Watched and unchanged since: no need to touch the disk at all
+    if (!watcher || !watcher->isClean(dirPath) || !index.lookup(dirPath, entries)) {
+        // Watch before reading, so that no later change can be missed
+        if (watcher)
+            watcher->watch(dirPath);
+        const auto dirMtime = dirModTime(dirPath);
+        if (dirMtime < 0)
+            return false;
+        if (!index.lookup(dirPath, dirMtime, entries)) {
+            DirListing all;
+            if (!allLister->list(dirPath, all))
+                return false;
+            // Every entry is a candidate of allParams (sub-folders are in both lists)
+            entries = std::move(all.candidates);
+            for (auto& entry : entries) {
+                if (entry.mtime < 0)
+                    entry.mtime = entry.fileInfo().lastModified().toMSecsSinceEpoch();
+                if (entry.size < 0)
+                    entry.size = entry.fileInfo().size();
+            }
+            index.store(dirPath, dirMtime, entries);
+        }
+    }
+
+    out.subDirs.reserve(entries.size());
+    out.candidates.reserve(entries.size());
+    for (auto& entry : entries) {
+        if (entry.hidden && params.exclHidden)
+            continue;
+        const auto candidate = isCandidate(entry.type, entry.name);
+        if (isArchive(entry.type, entry.name))
+            out.archives.push_back(entry);
+        if (entry.isDir()) {
+            if (candidate)
+                out.candidates.push_back(entry);
+            out.subDirs.push_back(std::move(entry));
+        }
+        else if (candidate) {
+            out.candidates.push_back(std::move(entry));
+        }
+    }
+    return true;
+}
+
+}
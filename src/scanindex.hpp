@@ -0,0 +1,122 @@
+#pragma once
+//
+// Copyright (c) Milivoj (Mike) DAVIDOV
+//
+// THIS SOFTWARE IS PROVIDED "AS IS" WITHOUT WARRANTY OF ANY KIND,
+// EITHER EXPRESSED OR IMPLIED, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+// WARRANTIES OF MERCHANTABILITY AND/OR FITNESS FOR A PARTICULAR PURPOSE.
+//
+
+#include "dirlister.hpp"
+#include "dirwatcher.hpp"
+#include "scanparams.hpp"
+#include <atomic>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <shared_mutex>
+#include <vector>
+#include <QByteArray>
+#include <QString>
+
+namespace mmd
+{
+/// @brief Persistent index of scanned folders: for each folder its
+/// modification time and all its entries (name, type, hidden, size, mtime).
+/// A folder's entries are reused as long as the folder's mtime is unchanged,
+/// i.e. no entry was created, deleted or renamed in it, so a repeated search
+/// only re-reads the folders that changed.
+/// Note that the size and mtime of a file are those seen when its folder
+/// was last read (changing a file's contents does not change its folder).
+/// It is stored in a compact binary file next to the app settings (Cfg).
+/// With a DirWatcher, the folders that are watched and have not changed
+/// are served without reading their modification time either.
+/// All members are thread-safe.
+/// @author Milivoj (Mike) DAVIDOV
+///
+class ScanIndex
+{
+public:
+    explicit ScanIndex(const QString& filePath);
+
+    /// Returns the index file in the app settings location.
+    static QString defaultFilePath();
+    const QString& fileName() const { return filePath; }
+
+    /// @brief Loads the index file once (later calls do nothing).
+    /// A missing, corrupt or old-version file gives an empty index.
+    void load();
+
+    /// Writes the index file if anything changed since load() or the previous save().
+    bool save();
+
+    /// @brief Gets the entries of @p dirPath if they were indexed
+    /// while the folder had the modification time @p dirMtime (msec).
+    bool lookup(const QString& dirPath, qint64 dirMtime, std::vector<FsEntry>& entries) const;
+
+    /// Gets the entries of @p dirPath if it is indexed, whatever its modification time.
+    bool lookup(const QString& dirPath, std::vector<FsEntry>& entries) const;
+
+    /// @brief Replaces the entries of @p dirPath; forgets the indexed
+    /// sub-trees of its sub-folders that no longer exist.
+    void store(const QString& dirPath, qint64 dirMtime, const std::vector<FsEntry>& entries);
+
+    void clear();
+
+    void setDirWatcher(std::unique_ptr<DirWatcher> watcher);
+    DirWatcher* dirWatcher() const { return watcher.get(); }
+
+    /// Folders read from the index, and (re-)read from disk, since the last resetStats().
+    quint64 reusedDirs() const { return nbrReused; }
+    quint64 readDirs() const { return nbrRead; }
+    void resetStats();
+
+private:
+    struct EntryRecord {
+        qint64 size;
+        qint64 mtime;
+        quint32 nameOffset;  // into DirRecord::names
+        quint8 type;         // FsEntry::Type
+        quint8 hidden;
+    };
+    struct DirRecord {
+        qint64 mtime{ -1 };     // of the folder when it was read
+        qint64 listedAt{ -1 };  // when it was read (msec)
+        QByteArray names;       // UTF-8, each one terminated by '\0'
+        std::vector<EntryRecord> entries;
+    };
+
+    void eraseSubtree(const QString& dirPath);
+    void getEntries(const QString& dirPath, const DirRecord& rec, std::vector<FsEntry>& entries) const;
+
+    const QString filePath;
+    mutable std::shared_mutex mutex;
+    std::map<QString, DirRecord> dirs;
+    std::unique_ptr<DirWatcher> watcher;
+    bool loaded{ false };
+    bool dirty{ false };
+    std::mutex fileMutex;
+    mutable std::atomic<quint64> nbrReused{ 0 };
+    std::atomic<quint64> nbrRead{ 0 };
+};
+
+/// @brief DirLister that answers from a ScanIndex when a folder
+/// has not changed, and otherwise lists it (with all entries, so the index
+/// can serve any later search) and updates the index.
+/// The index entries are then classified by the current ScanParams.
+/// @author Milivoj (Mike) DAVIDOV
+///
+class IndexedDirLister : public DirLister
+{
+public:
+    IndexedDirLister(const ScanParams& scanParams, ScanIndex& scanIndex);
+
+    bool list(const QString& dirPath, DirListing& out) const override;
+
+private:
+    ScanIndex& index;
+    ScanParams allParams;  // lists everything, for the index
+    std::unique_ptr<DirLister> allLister;
+};
+
+}
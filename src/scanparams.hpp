@@ -22,6 +22,12 @@ struct ScanParams
     QStringList nameFilters;
     QDir::Filters itemTypeFilter;
     bool matchCase;
+    bool regex;  // searchWords (joined by spaces) and nameFilters are regular expressions
+    bool wholeWords;  // search and exclusion words (and regex matches) are whole words only
+    bool inclBinaryFiles;  // search the contents of binary files too (see looksBinary())
+    bool decompress;  // search the decompressed contents of gzip, zstd and xz files
+    quint64 maxDecompressedSize;  // bytes searched per compressed file, 0 means Decompressor::DEFAULT_MAX_SIZE
+    bool searchArchives;  // list zip and tar files as folders, and search their members
     bool inclFiles;
     bool inclFolders;
     bool inclSymlinks;
@@ -30,5 +36,15 @@ struct ScanParams
     QStringList exclusionWords;
     QStringList exclFilePatterns;
     QStringList exclFolderPatterns;
+    int nbrScanThreads;  // deepScan() worker threads, 0 means one per CPU core
+    int nbrContentThreads;  // deepScan() file content reader threads, 0 means one per CPU core
+    quint64 readMemoryBudget;  // bytes of file windows held by all the content readers, 0 means default
+    bool spareCache;  // drop the pages of searched files that were not cached before (Linux)
+    quint64 directReadMinSize;  // read files at least this big with O_DIRECT (Linux), 0 means never
+    bool qtDirListing;   // use the portable QDir listing even if a native one is available
+    bool uringStat;      // batch statx through io_uring (Linux); automatic on network file systems
+    bool syncStat;       // never batch statx, not even on network file systems
+    bool diskOrderReads; // read the files to search in batches in on-disk order; automatic on rotational disks
+    bool unorderedReads; // never order the reads, not even on rotational disks
 };
 }
@@ -0,0 +1,193 @@
+//
+// Copyright (c) Milivoj (Mike) DAVIDOV
+//
+// THIS SOFTWARE IS PROVIDED "AS IS" WITHOUT WARRANTY OF ANY KIND,
+// EITHER EXPRESSED OR IMPLIED, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+// WARRANTIES OF MERCHANTABILITY AND/OR FITNESS FOR A PARTICULAR PURPOSE.
+//
+
+#include "substringsearcher.hpp"
+#include <bit>
+#include <cstdint>
+#include <cstring>
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+#define MMD_SIMD_X86 1
+#include <immintrin.h>
+#if defined(_MSC_VER) && !defined(__clang__)
+#include <intrin.h>
+#define MMD_TARGET(t)
+#else
+#define MMD_TARGET(t) __attribute__((target(t)))
+#endif
+#endif
+
+namespace mmd
+{
+namespace
+{
+bool isUpperAscii(char c)
+{
+    return c >= 'A' && c <= 'Z';
+}
+
+bool isLowerAscii(char c)
+{
+    return c >= 'a' && c <= 'z';
+}
+
+char toLowerAscii(char c)
+{
+    return isUpperAscii(c) ? char(c - 'A' + 'a') : c;
+}
+
+using FindFn = std::size_t (*)(const SubstringSearcher&, const char*, std::size_t, std::size_t);
+
+std::size_t findScalar(const SubstringSearcher& s, const char* text, std::size_t len, std::size_t from)
+{
+    const auto n = s.size();
+    if (len < n)
+        return SubstringSearcher::npos;
+    if (s.matchesCase())
+        return std::string_view(text, len).find(s.bytes(), from);
+    const auto first = s.firstByte();
+    const auto firstOr = s.firstCaseBit();
+    for (auto i = from; i + n <= len; ++i) {
+        if (char(text[i] | firstOr) == first && s.equalsAt(text + i))
+            return i;
+    }
+    return SubstringSearcher::npos;
+}
+
+#if defined(MMD_SIMD_X86)
+MMD_TARGET("sse2")
+std::size_t findSse2(const SubstringSearcher& s, const char* text, std::size_t len, std::size_t from)
+{
+    const auto n = s.size();
+    const auto first = _mm_set1_epi8(s.firstByte());
+    const auto last = _mm_set1_epi8(s.lastByte());
+    const auto firstOr = _mm_set1_epi8(s.firstCaseBit());
+    const auto lastOr = _mm_set1_epi8(s.lastCaseBit());
+    auto i = from;
+    for (; i + n - 1 + 16 <= len; i += 16) {
+        const auto a = _mm_or_si128(_mm_loadu_si128(reinterpret_cast<const __m128i*>(text + i)), firstOr);
+        const auto b = _mm_or_si128(_mm_loadu_si128(reinterpret_cast<const __m128i*>(text + i + n - 1)), lastOr);
+        auto mask = unsigned(_mm_movemask_epi8(_mm_and_si128(_mm_cmpeq_epi8(a, first), _mm_cmpeq_epi8(b, last))));
+        while (mask) {
+            const auto pos = i + std::size_t(std::countr_zero(mask));
+            if (s.equalsAt(text + pos))
+                return pos;
+            mask &= mask - 1;
+        }
+    }
+    return findScalar(s, text, len, i);
+}
+
+MMD_TARGET("avx2")
+std::size_t findAvx2(const SubstringSearcher& s, const char* text, std::size_t len, std::size_t from)
+{
+    const auto n = s.size();
+    const auto first = _mm256_set1_epi8(s.firstByte());
+    const auto last = _mm256_set1_epi8(s.lastByte());
+    const auto firstOr = _mm256_set1_epi8(s.firstCaseBit());
+    const auto lastOr = _mm256_set1_epi8(s.lastCaseBit());
+    auto i = from;
+    for (; i + n - 1 + 32 <= len; i += 32) {
+        const auto a = _mm256_or_si256(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(text + i)), firstOr);
+        const auto b = _mm256_or_si256(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(text + i + n - 1)), lastOr);
+        auto mask = unsigned(_mm256_movemask_epi8(_mm256_and_si256(_mm256_cmpeq_epi8(a, first), _mm256_cmpeq_epi8(b, last))));
+        while (mask) {
+            const auto pos = i + std::size_t(std::countr_zero(mask));
+            if (s.equalsAt(text + pos))
+                return pos;
+            mask &= mask - 1;
+        }
+    }
+    return findSse2(s, text, len, i);
+}
+
+bool cpuHasAvx2()
+{
+#if defined(_MSC_VER) && !defined(__clang__)
+    int regs[4];
+    __cpuid(regs, 0);
+    if (regs[0] < 7)
+        return false;
+    // AVX and the OS saving the YMM registers (XSAVE), then AVX2
+    __cpuid(regs, 1);
+    if (!(regs[2] & (1 << 27)) || !(regs[2] & (1 << 28)))
+        return false;
+    if ((_xgetbv(0) & 6) != 6)
+        return false;
+    __cpuidex(regs, 7, 0);
+    return (regs[1] & (1 << 5)) != 0;
+#else
+    __builtin_cpu_init();
+    return __builtin_cpu_supports("avx2");
+#endif
+}
+#endif
+
+struct Kernel
+{
+    FindFn find;
+    const char* name;
+};
+
+const Kernel& kernel()
+{
+    static const Kernel selected = [] {
+#if defined(MMD_SIMD_X86)
+        if (cpuHasAvx2())
+            return Kernel{ findAvx2, "avx2" };
+        return Kernel{ findSse2, "sse2" };
+#else
+        return Kernel{ findScalar, "scalar" };
+#endif
+    }();
+    return selected;
+}
+}
+
+SubstringSearcher::SubstringSearcher(std::string_view word, bool caseSensitive)
+    : needle(word)
+    , matchCase(caseSensitive)
+{
+    if (needle.empty())
+        return;
+    if (!matchCase) {
+        for (auto& c : needle)
+            c = toLowerAscii(c);
+    }
+    first = needle.front();
+    last = needle.back();
+    if (!matchCase) {
+        firstOr = isLowerAscii(first) ? char(0x20) : char(0);
+        lastOr = isLowerAscii(last) ? char(0x20) : char(0);
+    }
+}
+
+std::size_t SubstringSearcher::find(const char* text, std::size_t len) const
+{
+    if (needle.empty() || len < needle.size())
+        return npos;
+    return kernel().find(*this, text, len, 0);
+}
+
+const char* SubstringSearcher::kernelName()
+{
+    return kernel().name;
+}
+
+bool SubstringSearcher::equalsAt(const char* text) const
+{
+    if (matchCase)
+        return std::memcmp(text, needle.data(), needle.size()) == 0;
+    for (std::size_t i = 0; i < needle.size(); ++i) {
+        if (toLowerAscii(text[i]) != needle[i])
+            return false;
+    }
+    return true;
+}
+
+}
@@ -0,0 +1,63 @@
+#pragma once
+//
+// Copyright (c) Milivoj (Mike) DAVIDOV
+//
+// THIS SOFTWARE IS PROVIDED "AS IS" WITHOUT WARRANTY OF ANY KIND,
+// EITHER EXPRESSED OR IMPLIED, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+// WARRANTIES OF MERCHANTABILITY AND/OR FITNESS FOR A PARTICULAR PURPOSE.
+//
+
+#include <cstddef>
+#include <string>
+#include <string_view>
+
+namespace mmd
+{
+/// @brief Finds one byte string (e.g. a UTF-8 word) in byte buffers,
+/// optionally ignoring the case of ASCII letters, with SIMD kernels:
+/// a block of 32 (AVX2) or 16 (SSE2) text positions is tested at once
+/// against the first and the last byte of the word, and only the positions
+/// that pass both are compared in full. Caseless tests cost one extra OR:
+/// (byte | 0x20) is the lowercase letter for, and only for, both cases of it.
+/// The kernel is chosen once at run time from the CPU features,
+/// with a scalar one for other CPUs.
+/// Words with non-ASCII letters need Unicode case folding, which is not
+/// done here (see ContentMatcher::needsDecoding()).
+/// @author Milivoj (Mike) DAVIDOV
+///
+class SubstringSearcher
+{
+public:
+    static constexpr std::size_t npos = std::string_view::npos;
+
+    SubstringSearcher() = default;
+    SubstringSearcher(std::string_view word, bool matchCase);
+
+    bool isEmpty() const { return needle.empty(); }
+    std::size_t size() const { return needle.size(); }
+
+    /// Offset of the first match in the @p len bytes of @p text, or npos
+    std::size_t find(const char* text, std::size_t len) const;
+
+    /// Name of the kernel in use: "avx2", "sse2" or "scalar"
+    static const char* kernelName();
+
+    // Used by the kernels
+    bool equalsAt(const char* text) const;
+    const std::string& bytes() const { return needle; }
+    char firstByte() const { return first; }
+    char lastByte() const { return last; }
+    char firstCaseBit() const { return firstOr; }
+    char lastCaseBit() const { return lastOr; }
+    bool matchesCase() const { return matchCase; }
+
+private:
+    std::string needle;  // lowercase if not matchCase
+    bool matchCase{ true };
+    char first{ 0 };
+    char last{ 0 };
+    char firstOr{ 0 };  // 0x20 if first is a letter and not matchCase
+    char lastOr{ 0 };
+};
+
+}
@@ -0,0 +1,263 @@
+//
+// Copyright (c) Milivoj (Mike) DAVIDOV
+//
+// THIS SOFTWARE IS PROVIDED "AS IS" WITHOUT WARRANTY OF ANY KIND,
+// EITHER EXPRESSED OR IMPLIED, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+// WARRANTIES OF MERCHANTABILITY AND/OR FITNESS FOR A PARTICULAR PURPOSE.
+//
+
+#include "uringstatx_linux.hpp"
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <linux/io_uring.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+namespace mmd
+{
+namespace
+{
+constexpr unsigned RING_ENTRIES = 256;
+
+// Result of an entry that has not completed (the CQE results are 0 or -errno)
+constexpr int PENDING = 1;
+
+int ioUringSetup(unsigned entries, io_uring_params* p)
+{
+    return int(::syscall(__NR_io_uring_setup, entries, p));
+}
+
+int ioUringEnter(int fd, unsigned toSubmit, unsigned minComplete, unsigned flags)
+{
+    return int(::syscall(__NR_io_uring_enter, fd, toSubmit, minComplete, flags, nullptr, 0));
+}
+
+int ioUringRegister(int fd, unsigned opcode, void* arg, unsigned nrArgs)
+{
+    return int(::syscall(__NR_io_uring_register, fd, opcode, arg, nrArgs));
+}
+
+// The rings are shared with the kernel, hence the explicit ordering
+unsigned loadAcquire(const unsigned* p)
+{
+    return __atomic_load_n(p, __ATOMIC_ACQUIRE);
+}
+
+void storeRelease(unsigned* p, unsigned v)
+{
+    __atomic_store_n(p, v, __ATOMIC_RELEASE);
+}
+
+template <typename T>
+T* at(void* base, unsigned offset)
+{
+    return reinterpret_cast<T*>(static_cast<char*>(base) + offset);
+}
+}
+
+UringStatx& UringStatx::forThread()
+{
+    thread_local UringStatx instance;
+    return instance;
+}
+
+UringStatx::UringStatx()
+{
+    if (!setup(RING_ENTRIES))
+        teardown();
+}
+
+UringStatx::~UringStatx()
+{
+    teardown();
+}
+
+bool UringStatx::setup(unsigned entries)
+{
+    io_uring_params p;
+    std::memset(&p, 0, sizeof(p));
+    ringFd = ioUringSetup(entries, &p);
+    if (ringFd < 0)
+        return false;  // ENOSYS, EPERM (io_uring_disabled sysctl, seccomp), ...
+
+    // IORING_OP_STATX needs Linux 5.6
+    std::vector<char> probeBuf(sizeof(io_uring_probe) + 256 * sizeof(io_uring_probe_op), 0);
+    auto* probe = reinterpret_cast<io_uring_probe*>(probeBuf.data());
+    if (ioUringRegister(ringFd, IORING_REGISTER_PROBE, probe, 256) < 0 ||
+        probe->last_op < IORING_OP_STATX ||
+        !(probe->ops[IORING_OP_STATX].flags & IO_URING_OP_SUPPORTED)) {
+        return false;
+    }
+
+    sqEntries = p.sq_entries;
+    sqRingSize = p.sq_off.array + p.sq_entries * sizeof(unsigned);
+    cqRingSize = p.cq_off.cqes + p.cq_entries * sizeof(io_uring_cqe);
+    const bool singleMmap = (p.features & IORING_FEAT_SINGLE_MMAP) != 0;
+    if (singleMmap)
+        sqRingSize = cqRingSize = std::max(sqRingSize, cqRingSize);
+
+    sqRing = ::mmap(nullptr, sqRingSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ringFd, IORING_OFF_SQ_RING);
+    if (sqRing == MAP_FAILED) {
+        sqRing = nullptr;
+        return false;
+    }
+    if (singleMmap) {
+        cqRing = sqRing;
+    }
+    else {
+        cqRing = ::mmap(nullptr, cqRingSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ringFd, IORING_OFF_CQ_RING);
+        if (cqRing == MAP_FAILED) {
+            cqRing = nullptr;
+            return false;
+        }
+    }
+    sqesSize = p.sq_entries * sizeof(io_uring_sqe);
+    auto* sqesMap = ::mmap(nullptr, sqesSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ringFd, IORING_OFF_SQES);
+    if (sqesMap == MAP_FAILED)
+        return false;
+    sqes = static_cast<io_uring_sqe*>(sqesMap);
+
+    sqHead  = at<unsigned>(sqRing, p.sq_off.head);
+    sqTail  = at<unsigned>(sqRing, p.sq_off.tail);
+    sqMask  = at<unsigned>(sqRing, p.sq_off.ring_mask);
+    sqArray = at<unsigned>(sqRing, p.sq_off.array);
+    cqHead  = at<unsigned>(cqRing, p.cq_off.head);
+    cqTail  = at<unsigned>(cqRing, p.cq_off.tail);
+    cqMask  = at<unsigned>(cqRing, p.cq_off.ring_mask);
+    cqes    = at<io_uring_cqe>(cqRing, p.cq_off.cqes);
+    return true;
+}
+
+void UringStatx::teardown()
+{
+    if (sqes)
+        ::munmap(sqes, sqesSize);
+    if (cqRing && cqRing != sqRing)
+        ::munmap(cqRing, cqRingSize);
+    if (sqRing)
+        ::munmap(sqRing, sqRingSize);
+    if (ringFd >= 0)
+        ::close(ringFd);
+    sqes = nullptr;
+    sqRing = cqRing = nullptr;
+    ringFd = -1;
+}
+
+void UringStatx::statSync(int dirFd, const std::vector<const char*>& names, unsigned mask,
+                          std::vector<struct statx>& stats, std::vector<int>& results)
+{
+    stats.resize(names.size());
+    results.resize(names.size());
+    for (std::size_t i = 0; i < names.size(); ++i) {
+        results[i] = (::statx(dirFd, names[i], AT_SYMLINK_NOFOLLOW, mask, &stats[i]) == 0) ? 0 : -errno;
+    }
+}
+
+void UringStatx::statBatch(int dirFd, const std::vector<const char*>& names, unsigned mask,
+                           std::vector<struct statx>& stats, std::vector<int>& results)
+{
+    // A ring round trip only pays off when there is something to overlap
+    if (!isAvailable() || names.size() < 4) {
+        statSync(dirFd, names, mask, stats, results);
+        return;
+    }
+    stats.resize(names.size());
+    results.assign(names.size(), PENDING);
+    for (std::size_t first = 0; first < names.size(); first += sqEntries) {
+        const auto count = std::min<std::size_t>(sqEntries, names.size() - first);
+        if (!submitAndReap(dirFd, names, first, count, mask, stats, results)) {
+            // The ring is unusable (should not happen): finish synchronously from now on,
+            // the entries that did not complete in it
+            teardown();
+            for (std::size_t i = first; i < names.size(); ++i) {
+                if (results[i] == PENDING)
+                    results[i] = (::statx(dirFd, names[i], AT_SYMLINK_NOFOLLOW, mask, &stats[i]) == 0) ? 0 : -errno;
+            }
+            return;
+        }
+    }
+}
+
+bool UringStatx::submitAndReap(int dirFd, const std::vector<const char*>& names, std::size_t first, std::size_t count,
+                               unsigned mask, std::vector<struct statx>& stats, std::vector<int>& results)
+{
+    auto tail = *sqTail;  // only this thread writes the SQ tail
+    const auto sMask = *sqMask;
+    for (std::size_t i = first; i < first + count; ++i) {
+        const auto idx = tail & sMask;
+        auto* sqe = &sqes[idx];
+        std::memset(sqe, 0, sizeof(*sqe));
+        sqe->opcode = IORING_OP_STATX;
+        sqe->fd = dirFd;
+        sqe->addr = reinterpret_cast<std::uint64_t>(names[i]);
+        sqe->len = mask;
+        sqe->off = reinterpret_cast<std::uint64_t>(&stats[i]);
+        sqe->statx_flags = AT_SYMLINK_NOFOLLOW;
+        sqe->user_data = i;
+        sqArray[idx] = idx;
+        ++tail;
+    }
+    const auto submittedBefore = loadAcquire(sqHead);
+    storeRelease(sqTail, tail);
+
+    auto toSubmit = unsigned(count);
+    std::size_t reaped = 0;
+    while (reaped < count) {
+        const auto rc = ioUringEnter(ringFd, toSubmit, 1, IORING_ENTER_GETEVENTS);
+        if (rc < 0) {
+            if (errno == EINTR || errno == EAGAIN || errno == EBUSY)
+                continue;
+            // The kernel still writes to stats[] and results[] for the
+            // entries it took: wait for them before the ring is closed
+            const auto inFlight = std::size_t(loadAcquire(sqHead) - submittedBefore) - reaped;
+            if (!drain(inFlight, results))
+                abandon();
+            return false;
+        }
+        toSubmit -= std::min(toSubmit, unsigned(rc));
+        reaped += reap(results);
+    }
+    return true;
+}
+
+std::size_t UringStatx::reap(std::vector<int>& results)
+{
+    std::size_t reaped = 0;
+    auto head = *cqHead;  // only this thread moves the CQ head
+    const auto cqTailNow = loadAcquire(cqTail);
+    while (head != cqTailNow) {
+        const auto& cqe = cqes[head & *cqMask];
+        const auto i = std::size_t(cqe.user_data);
+        if (i < results.size())
+            results[i] = cqe.res;
+        ++head;
+        ++reaped;
+    }
+    storeRelease(cqHead, head);
+    return reaped;
+}
+
+bool UringStatx::drain(std::size_t inFlight, std::vector<int>& results)
+{
+    inFlight -= std::min(inFlight, reap(results));
+    while (inFlight > 0) {
+        if (ioUringEnter(ringFd, 0, 1, IORING_ENTER_GETEVENTS) < 0 && errno != EINTR)
+            return false;
+        inFlight -= std::min(inFlight, reap(results));
+    }
+    return true;
+}
+
+void UringStatx::abandon()
+{
+    // Left mapped and open: the kernel may still complete into the caller's memory,
+    // but never into a ring that was unmapped and reused
+    sqes = nullptr;
+    sqRing = cqRing = nullptr;
+    ringFd = -1;
+}
+
+}
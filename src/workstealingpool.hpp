@@ -0,0 +1,176 @@
+#pragma once
+//
+// Copyright (c) Milivoj (Mike) DAVIDOV
+//
+// THIS SOFTWARE IS PROVIDED "AS IS" WITHOUT WARRANTY OF ANY KIND,
+// EITHER EXPRESSED OR IMPLIED, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+// WARRANTIES OF MERCHANTABILITY AND/OR FITNESS FOR A PARTICULAR PURPOSE.
+//
+
+#include "set_thread_name.hpp"
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <optional>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace mmd
+{
+/// @brief Pool of worker threads, each with its own task deque.
+/// A worker pushes new tasks to the back of its own deque and pops
+/// them from the back (depth-first, cache friendly); an idle worker
+/// steals from the front of the other deques (breadth-first, big chunks).
+/// The pool is done when no task is queued or being visited,
+/// or when the @p stopped flag passed to run() becomes true.
+/// @author Milivoj (Mike) DAVIDOV
+///
+template <typename Task>
+class WorkStealingPool
+{
+public:
+    using Visitor = std::function<void(Task& task, std::size_t worker)>;
+
+    explicit WorkStealingPool(std::size_t nbrWorkers = 0)
+        : queues_(nbrWorkers > 0 ? nbrWorkers : defaultWorkerCount())
+    {
+    }
+
+    static std::size_t defaultWorkerCount() {
+        const auto n = std::thread::hardware_concurrency();
+        return n > 0 ? std::size_t(n) : std::size_t(4);
+    }
+
+    std::size_t size() const { return queues_.size(); }
+
+    /// Tasks queued or being visited
+    std::size_t queued() const { return pending_.load(std::memory_order_relaxed); }
+
+    /// Queue a task on the @p worker's own deque.
+    /// Called from the visitor with its own worker index.
+    void push(std::size_t worker, Task task) {
+        pending_.fetch_add(1, std::memory_order_acq_rel);
+        {
+            auto& q = queues_[worker % queues_.size()];
+            std::lock_guard<std::mutex> lock(q.mutex);
+            q.tasks.push_back(std::move(task));
+        }
+        if (sleepers_.load(std::memory_order_acquire) > 0)
+            wakeCv_.notify_one();
+    }
+
+    /// Visit @p seeds and every task pushed by the visitor on the worker threads.
+    /// The calling thread blocks until all work is done (or stopped),
+    /// calling @p poll about every 50 ms meanwhile.
+    void run(std::vector<Task> seeds, const Visitor& visit,
+             const std::atomic<bool>& stopped, const std::function<void()>& poll = {})
+    {
+        done_ = false;
+        std::size_t idx = 0;
+        for (auto& seed : seeds)
+            push(idx++, std::move(seed));
+        if (pending_.load() == 0)
+            return;
+        {
+            std::vector<std::jthread> workers;
+            workers.reserve(queues_.size());
+            for (std::size_t i = 0; i < queues_.size(); ++i) {
+                workers.emplace_back([this, i, &visit, &stopped]() {
+                    set_thread_name("ScanWorker");
+                    workerLoop(i, visit, stopped);
+                });
+            }
+            std::unique_lock<std::mutex> lock(doneMutex_);
+            while (!done_ && !stopped) {
+                doneCv_.wait_for(lock, std::chrono::milliseconds(50));
+                lock.unlock();
+                if (poll)
+                    poll();
+                lock.lock();
+            }
+            lock.unlock();
+            wakeCv_.notify_all();
+            // jthreads join here
+        }
+        if (poll)
+            poll();
+        for (auto& q : queues_)
+            q.tasks.clear();
+        pending_ = 0;
+    }
+
+private:
+    struct TaskQueue {
+        std::mutex mutex;
+        std::deque<Task> tasks;
+    };
+
+    std::optional<Task> popLocal(std::size_t worker) {
+        auto& q = queues_[worker];
+        std::lock_guard<std::mutex> lock(q.mutex);
+        if (q.tasks.empty())
+            return std::nullopt;
+        auto task = std::move(q.tasks.back());
+        q.tasks.pop_back();
+        return task;
+    }
+
+    std::optional<Task> steal(std::size_t thief) {
+        const auto n = queues_.size();
+        for (std::size_t k = 1; k < n; ++k) {
+            auto& q = queues_[(thief + k) % n];
+            std::unique_lock<std::mutex> lock(q.mutex, std::try_to_lock);
+            if (!lock.owns_lock() || q.tasks.empty())
+                continue;
+            auto task = std::move(q.tasks.front());
+            q.tasks.pop_front();
+            return task;
+        }
+        return std::nullopt;
+    }
+
+    void finish() {
+        {
+            std::lock_guard<std::mutex> lock(doneMutex_);
+            done_ = true;
+        }
+        doneCv_.notify_all();
+        wakeCv_.notify_all();
+    }
+
+    void workerLoop(std::size_t worker, const Visitor& visit, const std::atomic<bool>& stopped) {
+        while (!stopped && pending_.load(std::memory_order_acquire) > 0) {
+            auto task = popLocal(worker);
+            if (!task)
+                task = steal(worker);
+            if (task) {
+                visit(*task, worker);
+                if (pending_.fetch_sub(1, std::memory_order_acq_rel) == 1)
+                    finish();
+                continue;
+            }
+            // Nothing to do right now: other workers are still visiting
+            // and may push more tasks. The timeout covers a missed wake-up.
+            std::unique_lock<std::mutex> lock(wakeMutex_);
+            sleepers_.fetch_add(1, std::memory_order_acq_rel);
+            wakeCv_.wait_for(lock, std::chrono::milliseconds(2));
+            sleepers_.fetch_sub(1, std::memory_order_acq_rel);
+        }
+    }
+
+    std::vector<TaskQueue> queues_;
+    std::atomic<std::size_t> pending_{ 0 };
+    std::atomic<int> sleepers_{ 0 };
+    std::mutex wakeMutex_;
+    std::condition_variable wakeCv_;
+    std::mutex doneMutex_;
+    std::condition_variable doneCv_;
+    bool done_{ false };
+};
+
+}